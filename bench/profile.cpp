@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Robot/Motion/profile.hpp"
+#include "common.hpp"
+
+namespace
+{
+    constexpr double Tolerance = 1e-6;         // Final state in degrees and limits relative to the limit
+    constexpr double DurationTolerance = 1e-6; // Seconds the profile may differ from Ruckig
+
+    struct Timing
+    {
+        double total = 0; // ns
+        double worst = 0; // ns
+        size_t updates = 0;
+
+        void add(std::chrono::steady_clock::duration elapsed)
+        {
+            auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+            total += ns;
+            worst = std::max(worst, ns);
+            updates++;
+        }
+    };
+
+    //! @brief Step a backend through a move like the control loop
+    //!
+    //! @param peak Highest velocity and acceleration of each axis relative to its limit
+    //! @param path Position of every cycle
+    //! @return False if the backend reported an error or didn't finish
+    template <typename OTG>
+    bool run(OTG &otg, ruckig::InputParameter<4> input, ruckig::OutputParameter<4> &output, Timing &timing,
+             std::array<double, 2> &peak, std::vector<std::array<double, 4>> &path)
+    {
+        path.clear();
+        const size_t MaxCycles = 1000000;
+        for (size_t cycle = 0; cycle < MaxCycles; cycle++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto result = otg.update(input, output);
+            timing.add(std::chrono::steady_clock::now() - start);
+            if (result < 0)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < 4; i++)
+            {
+                peak[0] = std::max(peak[0], std::abs(output.new_velocity[i]) / input.max_velocity[i]);
+                peak[1] = std::max(peak[1], std::abs(output.new_acceleration[i]) / input.max_acceleration[i]);
+            }
+            path.push_back(output.new_position);
+            output.pass_to_input(input);
+            if (result == ruckig::Result::Finished)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! @brief Check that a backend came to rest at the target
+    bool arrived(const ruckig::InputParameter<4> &input, const ruckig::OutputParameter<4> &output)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            if (std::abs(output.new_position[i] - input.target_position[i]) > Tolerance ||
+                std::abs(output.new_velocity[i]) > Tolerance || std::abs(output.new_acceleration[i]) > Tolerance)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+//! @brief Differential check and timing of the profile backend against Ruckig
+//!
+//! Plans random rest to rest moves of four axes with both backends and steps each through to the
+//! end like the control loop. Both have to arrive at the target at rest within the limits, and the
+//! profile has to take Ruckig's time synchronised duration within DurationTolerance. The axes that
+//! could arrive earlier may take a different shape to get there in time, the largest position
+//! difference along the way is reported. The update time of both is reported per cycle, mean and
+//! worst case. Exits with 1 if any move fails.
+//!
+//! Usage: bench-profile [moves] [seed]
+int main(int argc, char **argv)
+{
+    const size_t Moves = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const auto seed = argc > 2 ? std::stoul(argv[2]) : 1;
+    const auto dt = CYCLETIME / double(TS::NSEC_PER_SECOND);
+
+    std::mt19937_64 random(seed);
+    auto uniform = [&](double low, double high) { return std::uniform_real_distribution<double>(low, high)(random); };
+    // Limits spread over decades like the joints of a preset
+    auto decades = [&](double low, double high) { return std::pow(10, uniform(std::log10(low), std::log10(high))); };
+
+    ruckig::Ruckig<4> ruckig(dt);
+    Motion::JerkProfile<4> profile(dt);
+    Timing ruckigTiming, profileTiming;
+    size_t failures = 0;
+    double worstDifference = 0, worstDeviation = 0;
+    std::vector<std::array<double, 4>> ruckigPath, profilePath;
+
+    for (size_t move = 0; move < Moves; move++)
+    {
+        ruckig::InputParameter<4> input;
+        for (size_t i = 0; i < 4; i++)
+        {
+            input.current_position[i] = uniform(-180, 180);
+            // Some axes stay put
+            input.target_position[i] = uniform(0, 1) < 0.1 ? input.current_position[i] : uniform(-180, 180);
+            input.max_velocity[i] = decades(10, 1000);
+            input.max_acceleration[i] = decades(10, 10000);
+            input.max_jerk[i] = decades(10, 100000);
+        }
+
+        ruckig::Trajectory<4> trajectory;
+        if (ruckig.calculate(input, trajectory) < 0)
+        {
+            printf("move %zu: Ruckig failed to plan\n", move);
+            failures++;
+            continue;
+        }
+
+        ruckig::OutputParameter<4> ruckigOutput, profileOutput;
+        std::array<double, 2> ruckigPeak = {}, profilePeak = {};
+        ruckig.reset();
+        profile.reset();
+        auto ruckigDone = run(ruckig, input, ruckigOutput, ruckigTiming, ruckigPeak, ruckigPath);
+        auto profileDone = run(profile, input, profileOutput, profileTiming, profilePeak, profilePath);
+
+        auto difference = std::abs(profile.getDuration() - trajectory.get_duration());
+        auto ok = ruckigDone && profileDone && arrived(input, ruckigOutput) && arrived(input, profileOutput) &&
+                  std::max(ruckigPeak[0], profilePeak[0]) <= 1 + Tolerance &&
+                  std::max(ruckigPeak[1], profilePeak[1]) <= 1 + Tolerance && difference <= DurationTolerance;
+        if (!ok)
+        {
+            printf("move %zu: Ruckig %.6f s profile %.6f s, peak velocity %.6f acceleration %.6f of the limit\n", move,
+                   trajectory.get_duration(), profile.getDuration(), profilePeak[0], profilePeak[1]);
+            failures++;
+            continue;
+        }
+        worstDifference = std::max(worstDifference, difference);
+        for (size_t cycle = 0; cycle < std::min(ruckigPath.size(), profilePath.size()); cycle++)
+        {
+            for (size_t i = 0; i < 4; i++)
+            {
+                worstDeviation = std::max(worstDeviation, std::abs(ruckigPath[cycle][i] - profilePath[cycle][i]));
+            }
+        }
+    }
+
+    printf("%zu moves, %zu failed\n", Moves, failures);
+    printf("duration difference to Ruckig: worst %.3g s, tolerance %.3g s\n", worstDifference, DurationTolerance);
+    printf("position difference to Ruckig along the way: worst %.3f°\n", worstDeviation);
+    printf("Ruckig update: mean %.0f ns worst %.0f ns\n", ruckigTiming.total / ruckigTiming.updates,
+           ruckigTiming.worst);
+    printf("profile update: mean %.0f ns worst %.0f ns\n", profileTiming.total / profileTiming.updates,
+           profileTiming.worst);
+    return failures > 0;
+}
@@ -1,7 +1,11 @@
 #ifndef NC_CONTROL_HPP
 #define NC_CONTROL_HPP
 
+#include <functional>
+#include <future>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "nlohmann/json.hpp"
 
@@ -55,6 +59,35 @@ namespace NC
             return;
         }
 
+        // Belt position stream for conveyor tracking
+        natsSubscription *conveyorSub = nullptr;
+        ncStatus = natsConnection_Subscribe(
+            &conveyorSub, nc, "conveyor.position",
+            []([[maybe_unused]] natsConnection *nc, [[maybe_unused]] natsSubscription *sub, natsMsg *msg,
+               void *closure) {
+                auto fsm = static_cast<Robot::FSM *>(closure);
+
+                try
+                {
+                    auto payload = json::parse(natsMsg_GetData(msg));
+                    fsm->conveyor.receive(payload["position"].template get<double>(),
+                                          payload.value("velocity", 0.0),
+                                          payload["timestamp"].template get<int64_t>());
+                }
+                catch (const json::exception &e)
+                {
+                    spdlog::error("conveyorCb exception: {}", e.what());
+                }
+
+                natsMsg_Destroy(msg);
+            },
+            fsm);
+        if (ncStatus != NATS_OK)
+        {
+            spdlog::error("NATS subscription failure: {}", natsStatus_GetText(ncStatus));
+            return;
+        }
+
         // Settings store
         jsCtx *js = nullptr;
         auto jsStatus = natsConnection_JetStream(&js, nc, NULL);
@@ -64,32 +97,128 @@ namespace NC
             return;
         }
 
+        // Every setting is watched through one watcher that dispatches by key. An update that was
+        // taken is logged with its payload unless it is too long for the event log.
+        struct SettingWatch
+        {
+            std::function<bool(const json &payload)> update;
+            bool logged = true;
+        };
+        const std::unordered_map<std::string, SettingWatch> settingHandlers = {
+            {"dynamics.active",
+             {[fsm](const json &payload) {
+                 fsm->updateDynamics(payload.get<Robot::Preset>());
+                 return true;
+             }}},
+            {"conveyor",
+             {[fsm](const json &payload) { return fsm->updateConveyor(payload.get<Robot::ConveyorSettings>()); }}},
+            {"feedforward",
+             {[fsm](const json &payload) {
+                 fsm->updateFeedforward(payload.get<Robot::FeedforwardSettings>());
+                 return true;
+             }}},
+            {"model",
+             {[fsm](const json &payload) {
+                 fsm->updateModel(payload.get<Dynamics::Parameters>());
+                 return true;
+             }}},
+            {"loop",
+             {[fsm](const json &payload) {
+                 fsm->updateLoop(payload.get<Robot::LoopSettings>());
+                 return true;
+             }}},
+            {"compensation",
+             {[fsm](const json &payload) {
+                 if (!fsm->updateCompensation(payload))
+                 {
+                     return false;
+                 }
+                 fsm->eventLog.Info("Compensation tables updated");
+                 return true;
+             },
+             false}},
+            {"collision",
+             {[fsm](const json &payload) {
+                 fsm->updateCollision(payload.get<Dynamics::CollisionSettings>());
+                 return true;
+             }}},
+            {"thermal",
+             {[fsm](const json &payload) {
+                 fsm->updateThermal(payload.get<Dynamics::ThermalSettings>());
+                 return true;
+             }}},
+            {"payload",
+             {[fsm](const json &payload) {
+                 fsm->updatePayload(payload.get<Dynamics::PayloadSettings>());
+                 return true;
+             }}},
+        };
+
         auto settingsKV = KV(js, "setting");
+        std::vector<std::thread> watchers;
 
-        std::thread settingsKVThread(&KV::watch, settingsKV, "dynamics.active",
-                                     [fsm](kvOperation op, std::string key, std::string value) {
-                                         if (op != kvOp_Put)
-                                         {
-                                             return;
-                                         }
-
-                                         try
-                                         {
-                                             auto payload = json::parse(value);
-                                             auto settings = payload.get<Robot::Preset>();
-
-                                             fsm->updateDynamics(settings);
-                                             fsm->eventLog.Debug(fmt::format("Settings update: {}", key), payload);
-                                         }
-                                         catch (const json::parse_error &e)
-                                         {
-                                             spdlog::error("Settings parsing error: {}", e.what());
-                                         }
-                                         catch (const json::exception &e)
-                                         {
-                                             spdlog::error("Settings exception: {}", e.what());
-                                         }
-                                     });
+        watchers.emplace_back(
+            &KV::watchAll, &settingsKV, [fsm, &settingHandlers](kvOperation op, std::string key, std::string value) {
+                // Keys without a handler, like the results stored in the same bucket, are ignored
+                auto it = settingHandlers.find(key);
+                if (op != kvOp_Put || it == settingHandlers.end())
+                {
+                    return;
+                }
+
+                try
+                {
+                    auto payload = json::parse(value);
+                    if (!it->second.update(payload))
+                    {
+                        return;
+                    }
+                    if (it->second.logged)
+                    {
+                        fsm->eventLog.Debug(fmt::format("Settings update: {}", key), payload);
+                    }
+                    else
+                    {
+                        fsm->eventLog.Debug(fmt::format("Settings update: {}", key));
+                    }
+                }
+                catch (const json::parse_error &e)
+                {
+                    spdlog::error("Settings parsing error in {}: {}", key, e.what());
+                }
+                catch (const json::exception &e)
+                {
+                    spdlog::error("Settings exception in {}: {}", key, e.what());
+                }
+                catch (const std::invalid_argument &e)
+                {
+                    spdlog::error("Settings exception in {}: {}", key, e.what());
+                }
+            });
+
+        // Program store, programs are compiled as they are uploaded
+        auto programKV = KV(js, "program");
+
+        watchers.emplace_back(&KV::watchAll, &programKV, [fsm](kvOperation op, std::string key, std::string value) {
+            if (op == kvOp_Delete || op == kvOp_Purge)
+            {
+                fsm->removeProgram(key);
+                return;
+            }
+            if (op != kvOp_Put)
+            {
+                return;
+            }
+
+            try
+            {
+                fsm->loadProgram(key, json::parse(value));
+            }
+            catch (const json::parse_error &e)
+            {
+                spdlog::error("Program parsing error: {}", e.what());
+            }
+        });
 
         // Timing
         struct timespec tick;
@@ -99,6 +228,10 @@ namespace NC
         clock_gettime(CLOCK_MONOTONIC, &tick);
         TS::Increment(tick, period);
 
+        // Results of the autotune and identification are stored next to the hand tuned settings
+        auto resultKV = KV(js, "setting");
+        std::future<Dynamics::Identification> identification;
+
         bool run = true;
         while (run)
         {
@@ -106,6 +239,43 @@ namespace NC
 
             fsm->broadcastStatus(nc);
 
+            if (fsm->tunePending)
+            {
+                json preset = fsm->tunedPreset;
+                auto kvStatus = resultKV.put("dynamics." + fsm->tunedPreset.id, preset.dump());
+                if (kvStatus != NATS_OK)
+                {
+                    spdlog::error("Failed to store tuned preset: {}", natsStatus_GetText(kvStatus));
+                }
+                fsm->tunePending = false;
+            }
+
+            // The fit runs on its own worker once the excitation has been recorded, the recording stays
+            // untouched until identificationPending is cleared
+            if (fsm->identificationPending && !identification.valid())
+            {
+                std::array<bool, 4> excited;
+                for (size_t i = 0; i < 4; i++)
+                {
+                    excited[i] = fsm->excitation.settings.amplitude[i] != 0;
+                }
+                identification = std::async(std::launch::async, [parameters = fsm->model.parameters,
+                                                                 &samples = fsm->recording, excited] {
+                    return Dynamics::identify(parameters, samples, CYCLETIME / double(TS::NSEC_PER_SECOND), excited);
+                });
+            }
+            if (identification.valid() && identification.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                json identified = identification.get();
+                auto kvStatus = resultKV.put("model.identified", identified.dump());
+                if (kvStatus != NATS_OK)
+                {
+                    spdlog::error("Failed to store identified model: {}", natsStatus_GetText(kvStatus));
+                }
+                fsm->eventLog.Info("Identification complete", identified);
+                fsm->identificationPending = false;
+            }
+
             if (fsm->shutdown)
             {
                 run = false;
@@ -121,10 +291,15 @@ namespace NC
             TS::Increment(tick, period);
         }
 
-        settingsKVThread.join();
+        for (auto &watcher : watchers)
+        {
+            watcher.join();
+        }
 
         natsSubscription_Unsubscribe(ctrlSub);
         natsSubscription_Destroy(ctrlSub);
+        natsSubscription_Unsubscribe(conveyorSub);
+        natsSubscription_Destroy(conveyorSub);
 
         natsConnection_FlushTimeout(nc, 1000);
         natsConnection_Close(nc);
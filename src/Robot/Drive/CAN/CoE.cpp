@@ -75,6 +75,18 @@ void CANOpen::FSM::update(uint16_t status_word)
         }
         break;
     }
+    case CANOpenCommand::QUICK_STOP: {
+        // The drive brakes on its quick stop ramp, depending on the quick stop option code it then
+        // stays in quick stop active or drops to switch on disabled
+        control_word_ = control::word::QUICK_STOP;
+        if ((status::value::OFF_STATE & status_word_) == status::value::OFF_STATE)
+        {
+            motor_state_ = CANOpenState::OFF;
+            spdlog::trace("OFF_STATE status achieved after quick stop");
+            command_ = CANOpenCommand::NONE;
+        }
+        break;
+    }
     case CANOpenCommand::HOME: {
         switch (motor_state_)
         {
@@ -25,7 +25,8 @@ enum class CANOpenCommand
     NONE,
     ENABLE,
     DISABLE,
-    HOME
+    HOME,
+    QUICK_STOP
 };
 
 namespace CANOpen
@@ -93,16 +94,32 @@ namespace CANOpen
         // For more infos, see DS402, page 37
         enum mode : int8_t
         {
-            NO_MODE = -1,       // Default value to mean "error occurred"
-            POSITION = 1,       // Profiled position (point to point) mode
-            VELOCITY = 3,       // Profiled velocity mode
-            TORQUE = 4,         // Profiled torque mode
-            HOME = 6,           // Homing
-            POSITION_CYCLIC = 8 // Direct position control without ramps
+            NO_MODE = -1,        // Default value to mean "error occurred"
+            POSITION = 1,        // Profiled position (point to point) mode
+            VELOCITY = 3,        // Profiled velocity mode
+            TORQUE = 4,          // Profiled torque mode
+            HOME = 6,            // Homing
+            POSITION_CYCLIC = 8, // Direct position control without ramps
+            VELOCITY_CYCLIC = 9, // Direct velocity control, position loop in the controller
+            TORQUE_CYCLIC = 10   // Direct torque control, position and velocity loop in the controller
         };
 
     } // namespace control
 
+    // probe stores the touch probe function and status bits
+    // CANopen DS402  0x60B8 Touch probe function, 0x60B9 Touch probe status
+    namespace probe
+    {
+        uint16_t const ENABLE_PROBE_1 = 1U << 0;
+        uint16_t const CONTINUOUS = 1U << 1;
+        uint16_t const LATCH_RISING_EDGE = 1U << 4;
+        uint16_t const LATCH_FALLING_EDGE = 1U << 5;
+
+        uint16_t const PROBE_1_ENABLED = 1U << 0;
+        uint16_t const RISING_EDGE_STORED = 1U << 1;
+        uint16_t const FALLING_EDGE_STORED = 1U << 2;
+    } // namespace probe
+
     // Timeouts to prevent blocking the state machine in case of failure
     constexpr std::chrono::nanoseconds MOTOR_RESET_DELAY = 10ms;
     constexpr std::chrono::nanoseconds MOTOR_INIT_TIMEOUT = 1s;
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <cmath>
+
+#include "compensation.hpp"
+
+void Drive::to_json(json &j, const Compensation &c)
+{
+    j = json{{"start", c.start}, {"step", c.step}, {"forward", c.forward}, {"reverse", c.reverse}};
+}
+
+void Drive::from_json(const json &j, Compensation &c)
+{
+    j.at("start").get_to(c.start);
+    j.at("step").get_to(c.step);
+    j.at("forward").get_to(c.forward);
+    // Without hysteresis data both directions share the table
+    c.reverse = j.value("reverse", c.forward);
+}
+
+//! @brief Check the table can be looked up
+bool Drive::Compensation::valid() const
+{
+    return step > 0 && forward.size() >= 2 && reverse.size() == forward.size() &&
+           std::all_of(forward.begin(), forward.end(), [](double e) { return std::isfinite(e); }) &&
+           std::all_of(reverse.begin(), reverse.end(), [](double e) { return std::isfinite(e); });
+}
+
+//! @brief Interpolated error at a joint position
+//!
+//! The grid is uniform so the sample is found by division instead of a search, positions outside
+//! the table hold the error of the nearest end.
+//!
+//! @param position Joint position in degrees
+//! @param direction Direction of travel, negative selects the reverse table
+//! @return Error in degrees
+double Drive::Compensation::error(double position, int direction) const
+{
+    const auto &table = direction < 0 ? reverse : forward;
+    auto last = table.size() - 1;
+
+    auto index = (position - start) / step;
+    if (index <= 0)
+    {
+        return table.front();
+    }
+    if (index >= last)
+    {
+        return table.back();
+    }
+    auto i = size_t(index);
+    auto fraction = index - i;
+    return table[i] + (table[i + 1] - table[i]) * fraction;
+}
@@ -0,0 +1,32 @@
+#ifndef DRIVE_COMPENSATION_HPP
+#define DRIVE_COMPENSATION_HPP
+
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace Drive
+{
+    using json = nlohmann::json;
+
+    //! @brief Position error table of a joint
+    //!
+    //! Transmission error of the gear sampled on a uniform grid of joint positions, separately for
+    //! each direction of travel to capture hysteresis. The error is what the joint is ahead of the
+    //! motor position in degrees.
+    class Compensation
+    {
+      public:
+        double start = 0; // Joint position of the first sample in degrees
+        double step = 1;  // Degrees between samples
+        std::vector<double> forward;
+        std::vector<double> reverse;
+
+        bool valid() const;
+        double error(double position, int direction) const;
+    };
+    void to_json(json &j, const Compensation &c);
+    void from_json(const json &j, Compensation &c);
+} // namespace Drive
+
+#endif
@@ -15,10 +15,8 @@ int Delta::PO2SOconfig(uint16_t slave)
     wkc += ec_SDOwrite(slave, 0x60C2, 1, FALSE, sizeof(interpolationPeriod), &interpolationPeriod, EC_TIMEOUTRXM);
     wkc += ec_SDOwrite(slave, 0x60C2, 2, FALSE, sizeof(ratio), &ratio, EC_TIMEOUTRXM);
 
-    // Set homing mode
-    uint8_t homingMode = 34;  // Got to z index
+    // Set homing speeds, the homing method is part of the process data
     uint32_t accel = 10 * 10; // Speed in rpm
-    wkc += ec_SDOwrite(slave, 0x6098, 0, FALSE, sizeof(homingMode), &homingMode, EC_TIMEOUTRXM);
     wkc += ec_SDOwrite(slave, 0x6099, 1, FALSE, sizeof(accel), &accel, EC_TIMEOUTRXM);
     wkc += ec_SDOwrite(slave, 0x6099, 2, FALSE, sizeof(accel), &accel, EC_TIMEOUTRXM);
 
@@ -54,68 +52,3 @@ int Delta::PO2SOconfig(uint16_t slave)
 
     return wkc;
 }
-
-uint16_t Delta::PDO::getStatusWord() const
-{
-    return in->status_word;
-}
-
-int32_t Delta::PDO::getActualPosition() const
-{
-    return in->actual_position;
-}
-
-int32_t Delta::PDO::getActualVelocity() const
-{
-    return in->actual_velocity;
-}
-
-int16_t Delta::PDO::getActualTorque() const
-{
-    return in->actual_torque;
-}
-
-int32_t Delta::PDO::getFollowingError() const
-{
-    return in->following_error;
-}
-
-uint16_t Delta::PDO::getErrorCode() const
-{
-    return in->error_code;
-}
-
-uint32_t Delta::PDO::getDigitalInputs() const
-{
-    return in->digital_inputs;
-}
-
-bool Delta::PDO::getEmergencyStop() const
-{
-    return getDigitalInputs() & (1 << 16);
-}
-
-void Delta::PDO::setControlWord(uint16_t value)
-{
-    out->control_word = value;
-}
-
-void Delta::PDO::setTargetPosition(int32_t value)
-{
-    out->target_position = value;
-}
-
-void Delta::PDO::setTargetVelocity(int32_t value)
-{
-    out->target_velocity = value;
-}
-
-void Delta::PDO::setTargetTorque(int16_t value)
-{
-    out->target_torque = value;
-}
-
-void Delta::PDO::setDigitalOutputs(uint32_t value)
-{
-    out->digital_outputs = value;
-}
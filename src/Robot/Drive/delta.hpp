@@ -4,7 +4,6 @@
 #include <cstdint>
 
 #include "ethercat.h"
-#include "pdo.hpp"
 #include "spdlog/spdlog.h"
 
 namespace Delta
@@ -17,52 +16,140 @@ namespace Delta
         int32_t target_velocity;  // 0x60FF 0.1 rpm
         int16_t target_torque;    // 0x6071 0.1 %
         uint32_t digital_outputs; // 0x60FE sub 1 [16-19 DO1-DO4]
+        uint16_t touch_probe;     // 0x60B8 [0 Enable probe 1][1 Continuous][4 Latch rising edge]
+        int32_t velocity_offset;  // 0x60B1 0.1 rpm, velocity feedforward in CSP
+        int16_t torque_offset;    // 0x60B2 0.1 %, torque feedforward in CSP
+        int8_t mode_of_operation; // 0x6060
+        int8_t homing_method;     // 0x6098
     } rx_t;
-    constexpr uint32_t rx_mapping[] = {0x60400010, 0x607A0020, 0x60FF0020, 0x60710010, 0x60FE0120};
+    constexpr uint32_t rx_mapping[] = {0x60400010, 0x607A0020, 0x60FF0020, 0x60710010, 0x60FE0120,
+                                       0x60B80010, 0x60B10020, 0x60B20010, 0x60600008, 0x60980008};
     constexpr uint32_t rx_mapping_count = sizeof(rx_mapping) / sizeof(uint32_t);
 
     typedef struct PACKED
     {
-        uint16_t status_word;    // 0x6041
-        int32_t actual_position; // 0x6064 PPU
-        int32_t actual_velocity; // 0x606C 0.1 rpm
-        int16_t actual_torque;   // 0x6077 0.1 %
-        int32_t following_error; // 0x60F4 PPU
-        uint16_t error_code;     // 0x603F
-        uint32_t digital_inputs; // 0x60FD [0 Neg Limit][1 Pos Limit][2 Homing switch][16-19 DI1-DI4]
+        uint16_t status_word;         // 0x6041
+        int32_t actual_position;      // 0x6064 PPU
+        int32_t actual_velocity;      // 0x606C 0.1 rpm
+        int16_t actual_torque;        // 0x6077 0.1 %
+        int32_t following_error;      // 0x60F4 PPU
+        uint16_t error_code;          // 0x603F
+        uint32_t digital_inputs;      // 0x60FD [0 Neg Limit][1 Pos Limit][2 Homing switch][16-19 DI1-DI4]
+        uint16_t touch_probe_status;  // 0x60B9 [0 Probe 1 enabled][1 Rising edge stored]
+        int32_t touch_probe_position; // 0x60BA PPU
+        int8_t mode_display;          // 0x6061 Mode of operation the drive is running in
     } tx_t;
-    constexpr uint32_t tx_mapping[] = {0x60410010, 0x60640020, 0x606C0020, 0x60770010,
-                                       0x60F40020, 0x603F0010, 0x60FD0020};
+    constexpr uint32_t tx_mapping[] = {0x60410010, 0x60640020, 0x606C0020, 0x60770010, 0x60F40020,
+                                       0x603F0010, 0x60FD0020, 0x60B90010, 0x60BA0020, 0x60610008};
     constexpr uint32_t tx_mapping_count = sizeof(tx_mapping) / sizeof(uint32_t);
 
+    constexpr int8_t DefaultHomingMethod = 34; // Go to z index
+
     int PO2SOconfig(uint16_t slave);
 
-    class PDO : public Drive::PDO
+    //! @brief Process data of a Delta drive in the IOmap
+    //!
+    //! The accessors are defined in the class so the drive code compiles them down to loads and
+    //! stores on the IOmap.
+    class PDO
     {
       public:
-        tx_t *in;
-        rx_t *out;
+        tx_t *in = nullptr;
+        rx_t *out = nullptr;
 
+        PDO() = default;
         PDO(int slaveID)
         {
             in = (Delta::tx_t *)ec_slave[slaveID].inputs;
             out = (Delta::rx_t *)ec_slave[slaveID].outputs;
+            out->homing_method = DefaultHomingMethod;
         }
 
-        uint16_t getStatusWord() const;
-        int32_t getActualPosition() const;
-        int32_t getActualVelocity() const;
-        int16_t getActualTorque() const;
-        int32_t getFollowingError() const;
-        uint16_t getErrorCode() const;
-        uint32_t getDigitalInputs() const;
-        bool getEmergencyStop() const;
+        uint16_t getStatusWord() const
+        {
+            return in->status_word;
+        }
+        int32_t getActualPosition() const
+        {
+            return in->actual_position;
+        }
+        int32_t getActualVelocity() const
+        {
+            return in->actual_velocity;
+        }
+        int16_t getActualTorque() const
+        {
+            return in->actual_torque;
+        }
+        int32_t getFollowingError() const
+        {
+            return in->following_error;
+        }
+        uint16_t getErrorCode() const
+        {
+            return in->error_code;
+        }
+        uint32_t getDigitalInputs() const
+        {
+            return in->digital_inputs;
+        }
+        bool getEmergencyStop() const
+        {
+            return getDigitalInputs() & (1 << 16);
+        }
+        uint16_t getTouchProbeStatus() const
+        {
+            return in->touch_probe_status;
+        }
+        int32_t getTouchProbePosition() const
+        {
+            return in->touch_probe_position;
+        }
+        int8_t getModeOfOperationDisplay() const
+        {
+            return in->mode_display;
+        }
 
-        void setControlWord(uint16_t value);
-        void setTargetPosition(int32_t value);
-        void setTargetVelocity(int32_t value);
-        void setTargetTorque(int16_t value);
-        void setDigitalOutputs(uint32_t value);
+        void setControlWord(uint16_t value)
+        {
+            out->control_word = value;
+        }
+        void setTargetPosition(int32_t value)
+        {
+            out->target_position = value;
+        }
+        void setTargetVelocity(int32_t value)
+        {
+            out->target_velocity = value;
+        }
+        void setTargetTorque(int16_t value)
+        {
+            out->target_torque = value;
+        }
+        void setDigitalOutputs(uint32_t value)
+        {
+            out->digital_outputs = value;
+        }
+        void setTouchProbeFunction(uint16_t value)
+        {
+            out->touch_probe = value;
+        }
+        void setVelocityOffset(int32_t value)
+        {
+            out->velocity_offset = value;
+        }
+        void setTorqueOffset(int16_t value)
+        {
+            out->torque_offset = value;
+        }
+        void setModeOfOperation(int8_t value)
+        {
+            out->mode_of_operation = value;
+        }
+        void setHomingMethod(int8_t value)
+        {
+            out->homing_method = value;
+        }
     };
 } // namespace Delta
 
@@ -1,4 +1,5 @@
 #include "drive.hpp"
+#include "../../common.hpp"
 
 //! @brief Update CoE state machine
 //!
@@ -10,22 +11,25 @@
 //! earth orbit. For safety the target is set to the current position every cycle.
 void Drive::Motor::update()
 {
-    CANOpen::FSM::update(pdo->getStatusWord());
+    CANOpen::FSM::update(pdo.getStatusWord());
     if (compareState(CANOpenState::FAULT) && !fault)
     {
-        lastFault = fmt::format("Drive {} CoE entered {} state", slaveID, CANOpen::FSM::to_string());
+        raiseFault(fmt::format("Drive {} CoE entered {} state", slaveID, CANOpen::FSM::to_string()));
         spdlog::error(lastFault);
-        fault = true;
     }
-    auto errorCode = pdo->getErrorCode();
+    auto errorCode = pdo.getErrorCode();
     if (errorCode != 0 && !fault)
     {
-        lastFault = fmt::format("Drive {} error code {:#x}", slaveID, errorCode);
+        raiseFault(fmt::format("Drive {} error code {:#x}", slaveID, errorCode));
         spdlog::error(lastFault);
-        fault = true;
     }
-    pdo->setControlWord(CANOpen::FSM::getControlWord());
-    pdo->setTargetPosition(pdo->getActualPosition());
+    pdo.setControlWord(CANOpen::FSM::getControlWord());
+    pdo.setTargetPosition(pdo.getActualPosition());
+    pdo.setTargetVelocity(0);
+    pdo.setTargetTorque(0);
+    pdo.setVelocityOffset(0);
+    pdo.setTorqueOffset(0);
+    pdo.setDigitalOutputs(digitalOutputs);
 }
 
 //! @brief Move the drive to a target position
@@ -36,51 +40,136 @@ void Drive::Motor::update()
 //! threshold, or if the target position is outside the soft limits, an error message is logged and
 //! no movement is performed.
 //!
+//! The trajectory velocity is sent along as velocity offset scaled by the feedforward gain, so the
+//! drive doesn't have to build it from position differences and lag behind the target. The model
+//! torque is sent as torque offset in the same way so the drive doesn't wait on following error to
+//! accelerate the arm.
+//!
+//! In CSV and CST the position and velocity loop run here instead of in the drive. Every target is
+//! written in every mode and the velocity loop integrator tracks the actual torque while it isn't
+//! in use, so an axis switches mode without a step in its command.
+//!
 //! @param target The target position to move the motor to
+//! @param velocity The trajectory velocity at the target in degrees/s
+//! @param torque The torque needed to follow the trajectory in %
 //! @return True if the motor is in a fault state, false otherwise
-bool Drive::Motor::move(double target)
+bool Drive::Motor::move(double target, double velocity, double torque)
 {
     if (fault)
     {
         return fault;
     }
-    auto current = pdo->getActualPosition() / positionRatio;
+    auto current = getPosition();
     if (std::abs(target - current) > 300)
     {
-        fault = true;
-        lastFault = fmt::format("Target deviation", target, current);
+        raiseFault(fmt::format("Target deviation", target, current));
         return fault;
     }
     if (target < minPosition || target > maxPosition)
     {
-        fault = true;
-        lastFault = fmt::format("Outside soft limits", target);
+        raiseFault(fmt::format("Outside soft limits", target));
         return fault;
     }
-    torqueHistory.push_back(getTorque());
-    if (torqueHistory.size() > 500)
-    {
-        torqueHistory.pop_front();
-    }
-    auto torqueAvg = std::accumulate(torqueHistory.begin(), torqueHistory.end(), 0.0) / torqueHistory.size();
+    torqueStatistics.push(getTorque());
+    followingErrorStatistics.push(getFollowingError());
+    velocityStatistics.push(getVelocity());
+    auto torqueAvg = torqueStatistics.mean();
     if (std::abs(torqueAvg) > torqueThreshold)
     {
-        fault = true;
-        lastFault = fmt::format("Torque threshold exceeded: {}%", torqueAvg);
+        raiseFault(fmt::format("Torque threshold exceeded: {}%", torqueAvg));
         return fault;
     }
-    pdo->setTargetPosition(target * positionRatio);
+    const auto dt = CYCLETIME / double(TS::NSEC_PER_SECOND);
+    auto feedforward = std::max(std::min(torque * torqueFeedforward, 100.0), -100.0);
+    auto velocityCommand = velocity + gains.position * (target - current);
+    auto velocityError = velocityCommand - getVelocity();
+    if (cyclicMode != CANOpen::control::mode::TORQUE_CYCLIC)
+    {
+        // Track the actual torque so the velocity loop takes over without a step
+        loopIntegral = getTorque() - feedforward - gains.velocity * velocityError;
+    }
+    auto torqueCommand = feedforward + gains.velocity * velocityError + loopIntegral;
+    if (cyclicMode == CANOpen::control::mode::TORQUE_CYCLIC && std::abs(torqueCommand) < gains.limit)
+    {
+        // Conditional integration, the integrator holds while the command is saturated
+        loopIntegral += gains.velocity * gains.integral * velocityError * dt;
+    }
+    torqueCommand = std::max(std::min(torqueCommand, gains.limit), -gains.limit);
+
+    // Command the motor position that puts the joint on target
+    if (velocity != 0)
+    {
+        direction = velocity > 0 ? 1 : -1;
+    }
+    auto motorTarget = compensation != nullptr ? target - compensation->error(target, direction) : target;
+    pdo.setTargetPosition(motorTarget * positionRatio);
+    pdo.setTargetVelocity(velocityCommand * velocityRatio);
+    pdo.setTargetTorque(torqueCommand * 10);
+    switch (cyclicMode)
+    {
+    case CANOpen::control::mode::VELOCITY_CYCLIC:
+        pdo.setVelocityOffset(0);
+        pdo.setTorqueOffset(feedforward * 10);
+        break;
+    case CANOpen::control::mode::TORQUE_CYCLIC:
+        pdo.setVelocityOffset(0);
+        pdo.setTorqueOffset(0);
+        break;
+    default:
+        pdo.setVelocityOffset(velocity * velocityFeedforward * velocityRatio);
+        pdo.setTorqueOffset(feedforward * 10);
+        break;
+    }
     return fault;
 }
 
+//! @brief Latch a fault and the time it was detected
+void Drive::Motor::raiseFault(std::string reason)
+{
+    lastFault = reason;
+    fault = true;
+    faultTimestamp = std::chrono::steady_clock::now().time_since_epoch();
+}
+
+//! @brief Quick stop the drive through the process data
+//!
+//! The control word is written straight to the PDO so it goes out with the next frame, together
+//! with a target at the actual position in case the drive only holds position. The drive
+//! decelerates on its quick stop ramp without waiting on any mailbox transfer.
+void Drive::Motor::quickStop()
+{
+    if (fault)
+    {
+        return;
+    }
+    setCommand(CANOpenCommand::QUICK_STOP);
+    CANOpen::FSM::update(pdo.getStatusWord());
+    pdo.setControlWord(CANOpen::FSM::getControlWord());
+    pdo.setTargetPosition(pdo.getActualPosition());
+    pdo.setTargetVelocity(0);
+    pdo.setTargetTorque(0);
+    pdo.setVelocityOffset(0);
+    pdo.setTorqueOffset(0);
+}
+
+//! @brief Check if the drive is no longer moving the joint
+//!
+//! @return True if the drive is faulted, disabled or at standstill
+bool Drive::Motor::stopped()
+{
+    return fault || compareState(CANOpenState::OFF) || std::abs(getVelocity()) < StandstillVelocity;
+}
+
 //! @brief Get the current position of the drive
 //!
-//! This function returns the current position of the drive in degrees.
+//! This function returns the current position of the drive in degrees, corrected by the
+//! compensation table if one is loaded.
 //!
 //! @return The current position of the drive
 double Drive::Motor::getPosition() const
 {
-    return pdo->getActualPosition() / positionRatio;
+    auto position = pdo.getActualPosition() / positionRatio;
+    return compensation != nullptr ? position + compensation->error(position, direction) : position;
 }
 
 //! @brief Get the current velocity of the drive
@@ -90,7 +179,7 @@ double Drive::Motor::getPosition() const
 //! @return The current velocity of the drive
 double Drive::Motor::getVelocity() const
 {
-    return pdo->getActualVelocity() / velocityRatio;
+    return pdo.getActualVelocity() / velocityRatio;
 }
 
 //! @brief Get the current torque of the drive
@@ -100,7 +189,7 @@ double Drive::Motor::getVelocity() const
 //! @return The current torque of the drive
 double Drive::Motor::getTorque() const
 {
-    return pdo->getActualTorque() / 10.0;
+    return pdo.getActualTorque() / 10.0;
 }
 
 //! @brief Get the current following error of the drive
@@ -110,7 +199,7 @@ double Drive::Motor::getTorque() const
 //! @return The current following error of the drive
 double Drive::Motor::getFollowingError() const
 {
-    return pdo->getFollowingError() / positionRatio;
+    return pdo.getFollowingError() / positionRatio;
 }
 
 //! @brief Get the current error code of the drive
@@ -120,7 +209,49 @@ double Drive::Motor::getFollowingError() const
 //! @return The current error code of the drive
 uint16_t Drive::Motor::getErrorCode() const
 {
-    return pdo->getErrorCode();
+    return pdo.getErrorCode();
+}
+
+//! @brief Get the current digital input state of the drive
+//!
+//! This function returns the raw digital input object of the drive.
+//!
+//! @return The current digital inputs of the drive
+uint32_t Drive::Motor::getDigitalInputs() const
+{
+    return pdo.getDigitalInputs();
+}
+
+//! @brief Switch digital outputs of the drive
+//!
+//! The output image is written to the drive every cycle, changes go out with the next frame.
+//!
+//! @param mask Output bits to change
+//! @param state State to set the bits to
+void Drive::Motor::setDigitalOutput(uint32_t mask, bool state)
+{
+    digitalOutputs = state ? (digitalOutputs | mask) : (digitalOutputs & ~mask);
+}
+
+//! @brief Set the touch probe function of the drive
+//!
+//! @param function Value of 0x60B8, a latch is armed on the rising edge of its enable bits
+void Drive::Motor::setTouchProbe(uint16_t function)
+{
+    pdo.setTouchProbeFunction(function);
+}
+
+//! @brief Get the touch probe status of the drive
+uint16_t Drive::Motor::getTouchProbeStatus() const
+{
+    return pdo.getTouchProbeStatus();
+}
+
+//! @brief Get the position latched by the touch probe in degrees
+double Drive::Motor::getTouchProbePosition() const
+{
+    auto position = pdo.getTouchProbePosition() / positionRatio;
+    return compensation != nullptr ? position + compensation->error(position, direction) : position;
 }
 
 //! @brief Get the current emergency stop state of the drive
@@ -130,29 +261,87 @@ uint16_t Drive::Motor::getErrorCode() const
 //! @return The current emergency stop state of the drive
 bool Drive::Motor::getEmergencyStop() const
 {
-    return pdo->getEmergencyStop();
+    return pdo.getEmergencyStop();
+}
+
+//! @brief Check if SDO transfers queued for the drive are still outstanding
+bool Drive::Motor::mailboxBusy() const
+{
+    return !mailbox.done(mailboxTicket);
+}
+
+//! @brief Check if an SDO transfer for the drive was dropped since the flag was last cleared
+bool Drive::Motor::mailboxFailed() const
+{
+    return mailboxDropped;
+}
+
+void Drive::Motor::clearMailboxFailed()
+{
+    mailboxDropped = false;
+}
+
+//! @brief Queue an SDO write to the drive and remember its ticket
+//!
+//! A dropped write keeps the ticket of the last queued one and flags the drive instead, so
+//! mailboxBusy can't report it as done.
+//!
+//! @return Mailbox ticket of the transfer, 0 if it was dropped
+template <typename T> uint64_t Drive::Motor::writeSDO(uint16_t index, T value)
+{
+    auto ticket = mailbox.write(slaveID, index, 0, value);
+    if (ticket == 0)
+    {
+        mailboxDropped = true;
+        return 0;
+    }
+    return mailboxTicket = ticket;
 }
 
 //! @brief Set the mode of operation for the drive
 //!
-//! This function sets the mode of operation for the drive.
+//! The mode is part of the process data and goes out with the next frame, modeConfirmed tells
+//! once the drive shows it in the mode of operation display.
 //!
 //! @param value The mode of operation to set
-//! @return Current working counter
-int Drive::Motor::setModeOfOperation(CANOpen::control::mode value)
+void Drive::Motor::setModeOfOperation(CANOpen::control::mode value)
+{
+    modeOfOperation = value;
+    pdo.setModeOfOperation(value);
+}
+
+//! @brief Get the mode of operation the drive is running in
+CANOpen::control::mode Drive::Motor::getModeOfOperation() const
 {
-    return ec_SDOwrite(slaveID, 0x6060, 0, FALSE, sizeof(value), &value, EC_TIMEOUTRXM);
+    return CANOpen::control::mode(pdo.getModeOfOperationDisplay());
+}
+
+//! @brief Check if the drive runs in the mode of operation last set
+bool Drive::Motor::modeConfirmed() const
+{
+    return getModeOfOperation() == modeOfOperation;
+}
+
+//! @brief Switch the cyclic synchronous mode of the drive
+//!
+//! The targets written by move are valid in every cyclic mode and the velocity loop integrator
+//! already holds the actual torque, so the switch is bumpless at any time.
+//!
+//! @param value POSITION_CYCLIC, VELOCITY_CYCLIC or TORQUE_CYCLIC
+void Drive::Motor::switchCyclicMode(CANOpen::control::mode value)
+{
+    cyclicMode = value;
+    setModeOfOperation(value);
 }
 
 //! @brief Set the homing mode for the drive
 //!
-//! This function sets the homing mode for the drive.
+//! This function sets the homing mode for the drive through the process data.
 //!
 //! @param value The homing mode to set
-//! @return Current working counter
-int Drive::Motor::setHomingMode(int32_t value)
+void Drive::Motor::setHomingMode(int8_t value)
 {
-    return ec_SDOwrite(slaveID, 0x6098, 0, FALSE, sizeof(value), &value, EC_TIMEOUTRXM);
+    pdo.setHomingMethod(value);
 }
 
 //! @brief Set the homing offset for the drive
@@ -161,19 +350,19 @@ int Drive::Motor::setHomingMode(int32_t value)
 //! adjust the position reported by the motor after homing.
 //!
 //! @param value The homing offset to set
-//! @return Current working counter
-int Drive::Motor::setHomingOffset(int32_t value)
+//! @return Mailbox ticket of the transfer
+uint64_t Drive::Motor::setHomingOffset(int32_t value)
 {
     auto final = int32_t(value * positionRatio);
-    return ec_SDOwrite(slaveID, 0x607C, 0, FALSE, sizeof(final), &final, EC_TIMEOUTRXM);
+    return writeSDO(0x607C, final);
 }
 
 //! @brief Set the torque limit for the drive in %
-int Drive::Motor::setTorqueLimit(double value)
+uint64_t Drive::Motor::setTorqueLimit(double value)
 {
     value = std::max(std::min(value, 100.0), 0.0);
     auto final = uint16_t(value * 10);
-    return ec_SDOwrite(slaveID, 0x6072, 0, FALSE, sizeof(final), &final, EC_TIMEOUTRXM);
+    return writeSDO(0x6072, final);
 }
 
 //! @brief Set the torque threshold for the drive in %
@@ -186,24 +375,66 @@ int Drive::Motor::setTorqueThreshold(double value)
 
 //! @brief Set the following window for the drive in degrees, outside of this window AL009
 //! is set and the drive requires reset.
-int Drive::Motor::setFollowingWindow(double value)
+uint64_t Drive::Motor::setFollowingWindow(double value)
 {
     value = std::max(value, 0.0);
     auto final = uint32_t(value * positionRatio);
-    return ec_SDOwrite(slaveID, 0x6065, 0, FALSE, sizeof(final), &final, EC_TIMEOUTRXM);
+    return writeSDO(0x6065, final);
+}
+
+//! @brief Set the velocity feedforward gain for the drive, 0 disables feedforward
+//!
+//! The drive's own position feedforward (P2-02) differentiates the target position, it is switched
+//! off while the trajectory velocity is fed forward so the velocity isn't added twice.
+uint64_t Drive::Motor::setVelocityFeedforward(double gain)
+{
+    velocityFeedforward = std::max(std::min(gain, 1.5), 0.0);
+    uint16_t positionFeedforward = velocityFeedforward > 0 ? 0 : 50; // % P2-02 default is 50
+    return writeSDO(0x2202, positionFeedforward);
+}
+
+//! @brief Set the torque feedforward gain for the drive, 0 disables feedforward
+int Drive::Motor::setTorqueFeedforward(double gain)
+{
+    torqueFeedforward = std::max(std::min(gain, 1.5), 0.0);
+    return 0;
 }
 
 //! @brief Reset the fault state of the drive
 //!
 //! This function resets the fault state of the drive. And sends a fault reset command to the motor.
 //!
-//! @return Current working counter
-int Drive::Motor::faultReset()
+//! @return Mailbox ticket of the transfer
+uint64_t Drive::Motor::faultReset()
 {
     spdlog::debug("Drive {} fault reset", slaveID);
-    torqueHistory.clear();
+    torqueStatistics.clear();
+    followingErrorStatistics.clear();
+    velocityStatistics.clear();
     fault = false;
     lastFault = "OK";
-    return ec_SDOwrite(slaveID, 0x6040, 0, FALSE, sizeof(CANOpen::control::word::FAULT_RESET),
-                       &CANOpen::control::word::FAULT_RESET, EC_TIMEOUTRXM);
+    return writeSDO(0x6040, CANOpen::control::word::FAULT_RESET);
+}
+
+std::string Drive::modeToString(CANOpen::control::mode value)
+{
+    switch (value)
+    {
+    case CANOpen::control::mode::POSITION:
+        return "position";
+    case CANOpen::control::mode::VELOCITY:
+        return "velocity";
+    case CANOpen::control::mode::TORQUE:
+        return "torque";
+    case CANOpen::control::mode::HOME:
+        return "home";
+    case CANOpen::control::mode::POSITION_CYCLIC:
+        return "positionCyclic";
+    case CANOpen::control::mode::VELOCITY_CYCLIC:
+        return "velocityCyclic";
+    case CANOpen::control::mode::TORQUE_CYCLIC:
+        return "torqueCyclic";
+    default:
+        return "none";
+    }
 }
@@ -2,55 +2,103 @@
 #define FSM_DRIVE_HPP
 
 #include "CAN/CoE.hpp"
+#include "compensation.hpp"
+#include "mailbox.hpp"
 #include "ethercat.h"
 #include "osal.h"
 #include "oshw.h"
 #include "pdo.hpp"
+#include "statistics.hpp"
 
-#include <deque>
-#include <numeric>
+#include <memory>
 
 namespace Drive
 {
     namespace fmt = spdlog::fmt_lib;
 
+    //! @brief Gains of the position and velocity loop run in the controller in CSV and CST
+    struct LoopGains
+    {
+        double position = 20;  // 1/s, velocity per degree of position error
+        double velocity = 0.5; // % torque per degree/s of velocity error
+        double integral = 10;  // 1/s, inverse integral time of the velocity loop
+        double limit = 100;    // % torque the loop may command
+    };
+
+    std::string modeToString(CANOpen::control::mode value);
+
     class Motor : public CANOpen::FSM
     {
       public:
+        static constexpr double StandstillVelocity = 1; // Degrees/s below which a stopping joint is at rest
+
         int slaveID;
-        std::unique_ptr<PDO> pdo;
+        PDO pdo;
         double positionRatio, velocityRatio;
         double minPosition, maxPosition;
         double torqueThreshold;
         bool fault;
         std::string lastFault = "OK";
-        std::deque<double> torqueHistory;
+        std::chrono::nanoseconds faultTimestamp = {}; // Steady clock time the fault was detected
+        // Over the last 500 cycles of motion, the torque threshold applies to the mean
+        WindowStatistics<500> torqueStatistics;
+        WindowStatistics<500> followingErrorStatistics;
+        WindowStatistics<500> velocityStatistics;
+        uint32_t digitalOutputs = 0;
+        double velocityFeedforward = 0; // Gain on the trajectory velocity sent as velocity offset
+        double torqueFeedforward = 0;   // Gain on the model torque sent as torque offset
+        CANOpen::control::mode cyclicMode = CANOpen::control::mode::POSITION_CYCLIC;
+        CANOpen::control::mode modeOfOperation = CANOpen::control::mode::NO_MODE; // Last mode written to the PDO
+        LoopGains gains;
+        double loopIntegral = 0; // % torque held by the velocity loop integrator
+        std::shared_ptr<const Compensation> compensation;
+        int direction = 1;          // Last direction of travel, selects the compensation table
+        uint64_t mailboxTicket = 0;  // Last SDO transfer queued for the drive
+        bool mailboxDropped = false; // An SDO transfer was dropped by the full mailbox queue
 
         Motor()
         {
             fault = true;
         }
-        Motor(int id, std::unique_ptr<PDO> pdoImpl, double positionRatio, double velocityRatio, double minimum,
-              double maximum)
+        Motor(int id, PDO pdoImpl, double positionRatio, double velocityRatio, double minimum, double maximum)
             : slaveID(id), pdo(std::move(pdoImpl)), positionRatio(positionRatio), velocityRatio(velocityRatio),
               minPosition(minimum), maxPosition(maximum), torqueThreshold(100), fault(false)
         {
         }
         void update();
-        bool move(double position);
+        bool move(double position, double velocity = 0, double torque = 0);
+        void raiseFault(std::string reason);
+        void quickStop();
+        bool stopped();
         double getPosition() const;
         double getVelocity() const;
         double getTorque() const;
         double getFollowingError() const;
         uint16_t getErrorCode() const;
+        uint32_t getDigitalInputs() const;
+        void setDigitalOutput(uint32_t mask, bool state);
+        void setTouchProbe(uint16_t function);
+        uint16_t getTouchProbeStatus() const;
+        double getTouchProbePosition() const;
         bool getEmergencyStop() const;
-        int setModeOfOperation(CANOpen::control::mode value);
-        int setHomingMode(int32_t value);
-        int setHomingOffset(int32_t value);
-        int setTorqueLimit(double value);
+        bool mailboxBusy() const;
+        bool mailboxFailed() const;
+        void clearMailboxFailed();
+        void setModeOfOperation(CANOpen::control::mode value);
+        CANOpen::control::mode getModeOfOperation() const;
+        bool modeConfirmed() const;
+        void switchCyclicMode(CANOpen::control::mode value);
+        void setHomingMode(int8_t value);
+        uint64_t setHomingOffset(int32_t value);
+        uint64_t setTorqueLimit(double value);
         int setTorqueThreshold(double value);
-        int setFollowingWindow(double value);
-        int faultReset();
+        uint64_t setFollowingWindow(double value);
+        uint64_t setVelocityFeedforward(double gain);
+        int setTorqueFeedforward(double gain);
+        uint64_t faultReset();
+
+      private:
+        template <typename T> uint64_t writeSDO(uint16_t index, T value);
     };
 
 } // namespace Drive
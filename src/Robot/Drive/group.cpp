@@ -16,24 +16,74 @@ void Drive::Group::setCommand(CANOpenCommand command)
     }
 }
 
-int Drive::Group::setModeOfOperation(CANOpen::control::mode value)
+//! @brief Start the per move peak and RMS of every drive
+void Drive::Group::holdStatistics()
 {
-    auto wkc = 0;
     for (auto &&drive : drives)
     {
-        wkc += drive->setModeOfOperation(value);
+        drive->torqueStatistics.hold();
+        drive->followingErrorStatistics.hold();
+        drive->velocityStatistics.hold();
     }
-    return wkc;
 }
 
-int Drive::Group::setTorqueLimit(double value)
+void Drive::Group::quickStop()
 {
-    auto wkc = 0;
     for (auto &&drive : drives)
     {
-        wkc += drive->setTorqueLimit(value);
+        drive->quickStop();
     }
-    return wkc;
+}
+
+bool Drive::Group::stopped() const
+{
+    for (auto &&drive : drives)
+    {
+        if (!drive->stopped())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Drive::Group::setModeOfOperation(CANOpen::control::mode value)
+{
+    for (auto &&drive : drives)
+    {
+        drive->setModeOfOperation(value);
+    }
+}
+
+void Drive::Group::switchCyclicMode(CANOpen::control::mode value)
+{
+    for (auto &&drive : drives)
+    {
+        drive->switchCyclicMode(value);
+    }
+}
+
+//! @brief Check if every drive of the group runs in the mode of operation last set
+bool Drive::Group::modeConfirmed() const
+{
+    for (auto &&drive : drives)
+    {
+        if (!drive->modeConfirmed())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t Drive::Group::setTorqueLimit(double value)
+{
+    uint64_t ticket = 0;
+    for (auto &&drive : drives)
+    {
+        ticket = std::max(ticket, drive->setTorqueLimit(value));
+    }
+    return ticket;
 }
 
 int Drive::Group::setTorqueThreshold(double value)
@@ -46,24 +96,58 @@ int Drive::Group::setTorqueThreshold(double value)
     return wkc;
 }
 
-int Drive::Group::setFollowingWindow(double value)
+uint64_t Drive::Group::setFollowingWindow(double value)
 {
-    auto wkc = 0;
+    uint64_t ticket = 0;
     for (auto &&drive : drives)
     {
-        wkc += drive->setFollowingWindow(value);
+        ticket = std::max(ticket, drive->setFollowingWindow(value));
     }
-    return wkc;
+    return ticket;
 }
 
-int Drive::Group::faultReset()
+uint64_t Drive::Group::faultReset()
 {
-    auto wkc = 0;
+    uint64_t ticket = 0;
     for (auto &&drive : drives)
     {
-        wkc += drive->faultReset();
+        ticket = std::max(ticket, drive->faultReset());
+    }
+    return ticket;
+}
+
+//! @brief Check if SDO transfers queued for any drive of the group are still outstanding
+bool Drive::Group::mailboxBusy() const
+{
+    for (auto &&drive : drives)
+    {
+        if (drive->mailboxBusy())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//! @brief Check if an SDO transfer for any drive of the group was dropped
+bool Drive::Group::mailboxFailed() const
+{
+    for (auto &&drive : drives)
+    {
+        if (drive->mailboxFailed())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Drive::Group::clearMailboxFailed()
+{
+    for (auto &&drive : drives)
+    {
+        drive->clearMailboxFailed();
     }
-    return wkc;
 }
 
 bool Drive::Group::getEmergencyStop() const
@@ -19,11 +19,19 @@ namespace Drive
 
         void update();
         void setCommand(CANOpenCommand command);
-        int setModeOfOperation(CANOpen::control::mode value);
-        int setTorqueLimit(double value);
+        void holdStatistics();
+        void quickStop();
+        bool stopped() const;
+        void setModeOfOperation(CANOpen::control::mode value);
+        void switchCyclicMode(CANOpen::control::mode value);
+        bool modeConfirmed() const;
+        uint64_t setTorqueLimit(double value);
         int setTorqueThreshold(double value);
-        int setFollowingWindow(double value);
-        int faultReset();
+        uint64_t setFollowingWindow(double value);
+        uint64_t faultReset();
+        bool mailboxBusy() const;
+        bool mailboxFailed() const;
+        void clearMailboxFailed();
         bool getEmergencyStop() const;
     };
 
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <thread>
+
+#include "../../common.hpp"
+#include "mailbox.hpp"
+
+Drive::Mailbox Drive::mailbox;
+
+void Drive::to_json(json &j, const Diagnostic &p)
+{
+    j = json{{"slave", p.slave}, {"index", p.index}, {"subIndex", p.subIndex}, {"value", p.value}, {"valid", p.valid}};
+}
+
+void Drive::to_json(json &j, const MailboxStatus &p)
+{
+    j = json{{"queued", p.queued},
+             {"completed", p.completed},
+             {"failed", p.failed},
+             {"timeouts", p.timeouts},
+             {"dropped", p.dropped},
+             {"lastDuration", p.lastDuration},
+             {"maxDuration", p.maxDuration},
+             {"meanDuration", p.meanDuration},
+             {"diagnostics", p.diagnostics}};
+}
+
+Drive::Mailbox::Mailbox()
+{
+    for (size_t i = 0; i < Capacity; i++)
+    {
+        queue[i].sequence = i;
+    }
+}
+
+//! @brief Copy a request into the queue
+//!
+//! Never blocks, so it is safe to call from the cyclic thread. A full queue drops the request,
+//! the worker logs the drops.
+//!
+//! @return Ticket of the request, 0 if the queue was full and the request was dropped
+uint64_t Drive::Mailbox::submit(Request request)
+{
+    auto position = tail.load(std::memory_order_relaxed);
+    while (true)
+    {
+        auto &slot = queue[position % Capacity];
+        auto sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence == position)
+        {
+            // Another producer may claim the position first, the exchange then loads the new tail
+            if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                request.ticket = position + 1;
+                slot.request = request;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return request.ticket;
+            }
+        }
+        else if (sequence < position)
+        {
+            // The slot still holds a request from the previous lap
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+        else
+        {
+            position = tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+//! @brief Check if a request is waiting for the worker
+bool Drive::Mailbox::pending()
+{
+    auto position = head.load(std::memory_order_relaxed);
+    return queue[position % Capacity].sequence.load(std::memory_order_acquire) == position + 1;
+}
+
+//! @brief Register an object to read every diagnostic interval
+//!
+//! @param size Bytes of the object, at most 8
+void Drive::Mailbox::diagnose(int slave, uint16_t index, uint8_t subIndex, int size)
+{
+    std::lock_guard lock(statusMutex);
+    diagnostics.push_back({.slave = slave, .index = index, .subIndex = subIndex, .size = std::min(size, 8)});
+}
+
+Drive::MailboxStatus Drive::Mailbox::status()
+{
+    // A claimed position may not be filled yet, close enough for the status
+    auto queued = tail.load() - head.load();
+
+    std::lock_guard lock(statusMutex);
+    auto result = metrics;
+    result.queued = queued;
+    result.dropped = dropped.load();
+    result.diagnostics = diagnostics;
+    return result;
+}
+
+//! @brief Run one SDO write and record how long the slave took to answer
+void Drive::Mailbox::transfer(const Request &request)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto data = request.data;
+    // There are no slaves behind the mailbox in simulation
+    auto wkc = SIMULATION ? 1
+                          : ec_SDOwrite(request.slave, request.index, request.subIndex, FALSE, request.size,
+                                        data.data(), Timeout);
+    auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard lock(statusMutex);
+        metrics.completed++;
+        metrics.lastDuration = duration;
+        metrics.maxDuration = std::max(metrics.maxDuration, duration);
+        totalDuration += duration;
+        metrics.meanDuration = totalDuration / metrics.completed;
+        if (wkc <= 0)
+        {
+            metrics.failed++;
+            if (duration >= Timeout / 1000.0)
+            {
+                metrics.timeouts++;
+            }
+        }
+    }
+
+    if (wkc <= 0)
+    {
+        spdlog::error("SDO write {:#06x}:{} to slave {} failed after {:.1f} ms", request.index, request.subIndex,
+                      request.slave, duration);
+    }
+    completed = request.ticket;
+}
+
+//! @brief Read every registered diagnostic object in one pass
+//!
+//! A queued request takes priority, the pass is abandoned and the objects not yet read keep
+//! their previous value.
+//!
+//! @return True if the pass read every object
+bool Drive::Mailbox::readDiagnostics()
+{
+    std::vector<Diagnostic> results;
+    {
+        std::lock_guard lock(statusMutex);
+        results = diagnostics;
+    }
+
+    auto complete = true;
+    for (auto &&diagnostic : results)
+    {
+        if (pending())
+        {
+            complete = false;
+            break;
+        }
+        int64_t value = 0;
+        auto size = diagnostic.size;
+        auto wkc = ec_SDOread(diagnostic.slave, diagnostic.index, diagnostic.subIndex, FALSE, &size, &value, Timeout);
+        diagnostic.valid = wkc > 0;
+        if (diagnostic.valid)
+        {
+            diagnostic.value = value;
+        }
+    }
+
+    std::lock_guard lock(statusMutex);
+    // Objects registered during the pass are picked up by the next one
+    std::copy(results.begin(), results.end(), diagnostics.begin());
+    return complete;
+}
+
+//! @brief Work through the queue until shutdown
+//!
+//! Runs on the housekeeping cores. Requests still queued at shutdown are transferred before
+//! returning so the drives are left in the mode the state machine asked for.
+//!
+//! @param shutdown Set once the controller is stopping
+void Drive::Mailbox::run(const bool *shutdown)
+{
+    Kernel::start_high_latency();
+
+    auto nextDiagnostics = std::chrono::steady_clock::now();
+    while (true)
+    {
+        // Drops are counted by the producers, the cyclic thread can't log
+        auto drops = dropped.load();
+        if (drops != reportedDrops)
+        {
+            spdlog::error("Mailbox queue full, dropped {} SDO writes", drops - reportedDrops);
+            reportedDrops = drops;
+        }
+
+        if (pending())
+        {
+            auto position = head.load(std::memory_order_relaxed);
+            auto &slot = queue[position % Capacity];
+            auto request = slot.request;
+            // Free the slot for the producers on the next lap
+            slot.sequence.store(position + Capacity, std::memory_order_release);
+            head.store(position + 1);
+            transfer(request);
+            continue;
+        }
+        if (*shutdown)
+        {
+            return;
+        }
+
+        if (!SIMULATION && std::chrono::steady_clock::now() >= nextDiagnostics && readDiagnostics())
+        {
+            nextDiagnostics = std::chrono::steady_clock::now() + DiagnosticInterval;
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
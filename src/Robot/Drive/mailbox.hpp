@@ -0,0 +1,124 @@
+#ifndef DRIVE_MAILBOX_HPP
+#define DRIVE_MAILBOX_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "ethercat.h"
+#include "nlohmann/json.hpp"
+
+namespace Drive
+{
+    using json = nlohmann::json;
+
+    //! @brief Object read periodically from a slave for diagnostics
+    struct Diagnostic
+    {
+        int slave;
+        uint16_t index;
+        uint8_t subIndex;
+        int size; // Bytes, at most 8
+        int64_t value = 0;
+        bool valid = false; // Last read succeeded
+    };
+    void to_json(json &j, const Diagnostic &p);
+
+    struct MailboxStatus
+    {
+        size_t queued;
+        size_t completed;
+        size_t failed;
+        size_t timeouts;     // Failed after waiting the full mailbox timeout
+        size_t dropped;      // Rejected because the queue was full
+        double lastDuration; // ms
+        double maxDuration;  // ms
+        double meanDuration; // ms
+        std::vector<Diagnostic> diagnostics;
+    };
+    void to_json(json &j, const MailboxStatus &p);
+
+    //! @brief SDO transfers queued by the control thread and run on a housekeeping core
+    //!
+    //! A mailbox round trip can take hundreds of milliseconds, so the cyclic thread only copies a
+    //! request into a fixed ring and gets a ticket back. A single worker runs the requests in the
+    //! order they were queued, which also serializes the transfers to each slave. Tickets complete
+    //! in order too, a ticket is done once every request queued before it is done. Between
+    //! requests the worker reads the registered diagnostic objects in one pass.
+    //!
+    //! The settings and command threads queue requests as well, so the ring takes any number of
+    //! producers without a lock. Each slot carries a sequence number that tells whether it is free
+    //! for the position a producer claimed or holds a request for the worker.
+    class Mailbox
+    {
+      public:
+        static constexpr size_t Capacity = 64;
+        static constexpr int Timeout = EC_TIMEOUTRXM; // us
+        static constexpr std::chrono::milliseconds DiagnosticInterval{1000};
+
+        Mailbox();
+
+        //! @brief Queue an SDO write of a plain value
+        //!
+        //! @return Ticket to poll with done, 0 if the queue was full
+        template <typename T> uint64_t write(int slave, uint16_t index, uint8_t subIndex, T value)
+        {
+            static_assert(sizeof(T) <= 8, "SDO writes through the mailbox are limited to 8 bytes");
+            Request request = {.slave = slave, .index = index, .subIndex = subIndex, .size = sizeof(T)};
+            std::memcpy(request.data.data(), &value, sizeof(T));
+            return submit(request);
+        }
+
+        //! @brief Check if the request of a ticket and all before it have been transferred
+        bool done(uint64_t ticket) const
+        {
+            return completed.load() >= ticket;
+        }
+
+        void diagnose(int slave, uint16_t index, uint8_t subIndex, int size);
+        MailboxStatus status();
+        void run(const bool *shutdown);
+
+      private:
+        struct Request
+        {
+            int slave;
+            uint16_t index;
+            uint8_t subIndex;
+            int size;
+            std::array<uint8_t, 8> data = {};
+            uint64_t ticket = 0;
+        };
+
+        uint64_t submit(Request request);
+        bool pending();
+        void transfer(const Request &request);
+        bool readDiagnostics();
+
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence; // Position the slot is free for, position + 1 once filled
+            Request request;
+        };
+
+        std::array<Slot, Capacity> queue;
+        std::atomic<uint64_t> tail = 0; // Next position claimed by a producer
+        std::atomic<uint64_t> head = 0; // Next position taken by the worker
+        std::atomic<size_t> dropped = 0;
+        size_t reportedDrops = 0; // Worker only
+        std::atomic<uint64_t> completed = 0;
+
+        std::mutex statusMutex;
+        MailboxStatus metrics = {};
+        double totalDuration = 0;
+        std::vector<Diagnostic> diagnostics;
+    };
+
+    extern Mailbox mailbox;
+} // namespace Drive
+
+#endif
@@ -1,30 +1,204 @@
 #ifndef FSM_PDO_HPP
 #define FSM_PDO_HPP
 
+#include <concepts>
 #include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+
+#include "../../common.hpp"
+#include "delta.hpp"
+#include "sim.hpp"
 
 namespace Drive
 {
-    class PDO
+    //! @brief Process data access a drive type has to provide
+    template <typename T>
+    concept ProcessData = requires(T pdo, const T constPdo) {
+        { constPdo.getStatusWord() } -> std::same_as<uint16_t>;
+        { constPdo.getActualPosition() } -> std::same_as<int32_t>;
+        { constPdo.getActualVelocity() } -> std::same_as<int32_t>;
+        { constPdo.getActualTorque() } -> std::same_as<int16_t>;
+        { constPdo.getFollowingError() } -> std::same_as<int32_t>;
+        { constPdo.getErrorCode() } -> std::same_as<uint16_t>;
+        { constPdo.getDigitalInputs() } -> std::same_as<uint32_t>;
+        { constPdo.getEmergencyStop() } -> std::same_as<bool>;
+        { constPdo.getTouchProbeStatus() } -> std::same_as<uint16_t>;
+        { constPdo.getTouchProbePosition() } -> std::same_as<int32_t>;
+        { constPdo.getModeOfOperationDisplay() } -> std::same_as<int8_t>;
+        pdo.setControlWord(uint16_t());
+        pdo.setTargetPosition(int32_t());
+        pdo.setTargetVelocity(int32_t());
+        pdo.setTargetTorque(int16_t());
+        pdo.setDigitalOutputs(uint32_t());
+        pdo.setTouchProbeFunction(uint16_t());
+        pdo.setVelocityOffset(int32_t());
+        pdo.setTorqueOffset(int16_t());
+        pdo.setModeOfOperation(int8_t());
+        pdo.setHomingMethod(int8_t());
+    };
+
+    //! @brief Process data of one of the drive types on the bus
+    //!
+    //! The drive types are fixed at compile time. A single type is held as is and every accessor is
+    //! a direct call, several are held in a variant and picked with a branch on its index. Either
+    //! way the accessors inline into the motor, there is no virtual call or heap object in the cycle.
+    template <ProcessData... Types> class BasicPDO
     {
       public:
-        virtual ~PDO() = default;
-
-        virtual uint16_t getStatusWord() const = 0;
-        virtual int32_t getActualPosition() const = 0;
-        virtual int32_t getActualVelocity() const = 0;
-        virtual int16_t getActualTorque() const = 0;
-        virtual int32_t getFollowingError() const = 0;
-        virtual uint16_t getErrorCode() const = 0;
-        virtual uint32_t getDigitalInputs() const = 0;
-        virtual bool getEmergencyStop() const = 0;
-
-        virtual void setControlWord(uint16_t value) = 0;
-        virtual void setTargetPosition(int32_t value) = 0;
-        virtual void setTargetVelocity(int32_t value) = 0;
-        virtual void setTargetTorque(int16_t value) = 0;
-        virtual void setDigitalOutputs(uint32_t value) = 0;
+        template <typename T> static constexpr bool holds = (std::same_as<T, Types> || ...);
+
+        BasicPDO() = default;
+        template <ProcessData T>
+            requires holds<T>
+        BasicPDO(T pdo) : pdo(std::move(pdo))
+        {
+        }
+
+        //! @brief Process data of a slave
+        //!
+        //! @param slave Slave position on the bus, 0 if the drive is missing or simulated
+        //! @return Nothing if the bus has no drive type for the slave
+        static std::optional<BasicPDO> attach(int slave)
+        {
+            if constexpr (holds<Delta::PDO>)
+            {
+                if (slave != 0)
+                {
+                    return BasicPDO(Delta::PDO(slave));
+                }
+            }
+            if constexpr (holds<Sim::PDO>)
+            {
+                spdlog::info("Simulated drive created");
+                return BasicPDO(Sim::PDO());
+            }
+            return std::nullopt;
+        }
+
+        uint16_t getStatusWord() const
+        {
+            return dispatch([](const auto &p) { return p.getStatusWord(); });
+        }
+        int32_t getActualPosition() const
+        {
+            return dispatch([](const auto &p) { return p.getActualPosition(); });
+        }
+        int32_t getActualVelocity() const
+        {
+            return dispatch([](const auto &p) { return p.getActualVelocity(); });
+        }
+        int16_t getActualTorque() const
+        {
+            return dispatch([](const auto &p) { return p.getActualTorque(); });
+        }
+        int32_t getFollowingError() const
+        {
+            return dispatch([](const auto &p) { return p.getFollowingError(); });
+        }
+        uint16_t getErrorCode() const
+        {
+            return dispatch([](const auto &p) { return p.getErrorCode(); });
+        }
+        uint32_t getDigitalInputs() const
+        {
+            return dispatch([](const auto &p) { return p.getDigitalInputs(); });
+        }
+        bool getEmergencyStop() const
+        {
+            return dispatch([](const auto &p) { return p.getEmergencyStop(); });
+        }
+        uint16_t getTouchProbeStatus() const
+        {
+            return dispatch([](const auto &p) { return p.getTouchProbeStatus(); });
+        }
+        int32_t getTouchProbePosition() const
+        {
+            return dispatch([](const auto &p) { return p.getTouchProbePosition(); });
+        }
+        int8_t getModeOfOperationDisplay() const
+        {
+            return dispatch([](const auto &p) { return p.getModeOfOperationDisplay(); });
+        }
+
+        void setControlWord(uint16_t value)
+        {
+            dispatch([value](auto &p) { p.setControlWord(value); });
+        }
+        void setTargetPosition(int32_t value)
+        {
+            dispatch([value](auto &p) { p.setTargetPosition(value); });
+        }
+        void setTargetVelocity(int32_t value)
+        {
+            dispatch([value](auto &p) { p.setTargetVelocity(value); });
+        }
+        void setTargetTorque(int16_t value)
+        {
+            dispatch([value](auto &p) { p.setTargetTorque(value); });
+        }
+        void setDigitalOutputs(uint32_t value)
+        {
+            dispatch([value](auto &p) { p.setDigitalOutputs(value); });
+        }
+        void setTouchProbeFunction(uint16_t value)
+        {
+            dispatch([value](auto &p) { p.setTouchProbeFunction(value); });
+        }
+        void setVelocityOffset(int32_t value)
+        {
+            dispatch([value](auto &p) { p.setVelocityOffset(value); });
+        }
+        void setTorqueOffset(int16_t value)
+        {
+            dispatch([value](auto &p) { p.setTorqueOffset(value); });
+        }
+        void setModeOfOperation(int8_t value)
+        {
+            dispatch([value](auto &p) { p.setModeOfOperation(value); });
+        }
+        void setHomingMethod(int8_t value)
+        {
+            dispatch([value](auto &p) { p.setHomingMethod(value); });
+        }
+
+      private:
+        static constexpr bool Single = sizeof...(Types) == 1;
+        std::conditional_t<Single, std::tuple_element_t<0, std::tuple<Types...>>, std::variant<Types...>> pdo;
+
+        template <typename F> decltype(auto) dispatch(F &&f) const
+        {
+            if constexpr (Single)
+            {
+                return f(pdo);
+            }
+            else
+            {
+                return std::visit(std::forward<F>(f), pdo);
+            }
+        }
+
+        template <typename F> decltype(auto) dispatch(F &&f)
+        {
+            if constexpr (Single)
+            {
+                return f(pdo);
+            }
+            else
+            {
+                return std::visit(std::forward<F>(f), pdo);
+            }
+        }
     };
+
+    // Hardware builds only run Delta drives, a bus with drives missing can be built to simulate them
+#ifdef WITH_MIXED_BUS
+    using PDO = BasicPDO<Delta::PDO, Sim::PDO>;
+#else
+    using PDO = std::conditional_t<SIMULATION, BasicPDO<Sim::PDO>, BasicPDO<Delta::PDO>>;
+#endif
 } // namespace Drive
 
 #endif
@@ -41,6 +41,23 @@ bool Sim::PDO::getEmergencyStop() const
     return false;
 }
 
+uint16_t Sim::PDO::getTouchProbeStatus() const
+{
+    // Probe enables but never latches
+    return touch_probe & 0x0001;
+}
+
+int32_t Sim::PDO::getTouchProbePosition() const
+{
+    return 0;
+}
+
+int8_t Sim::PDO::getModeOfOperationDisplay() const
+{
+    // The simulated drive switches at once
+    return mode_of_operation;
+}
+
 void Sim::PDO::setControlWord(uint16_t value)
 {
     control_word = value;
@@ -3,19 +3,18 @@
 
 #include <cstdint>
 
-#include "pdo.hpp"
 #include "spdlog/spdlog.h"
 
 namespace Sim
 {
-    class PDO : public Drive::PDO
+    class PDO
     {
       public:
         PDO()
             : status_word(0), following_error(0), digital_inputs(0), control_word(0), target_position(0),
-              target_velocity(0), target_torque(0), digital_outputs(0)
+              target_velocity(0), target_torque(0), digital_outputs(0), touch_probe(0), mode_of_operation(0),
+              homing_method(0)
         {
-            spdlog::info("Simulated drive created");
         }
 
         uint16_t status_word;
@@ -27,6 +26,9 @@ namespace Sim
         int32_t target_velocity;
         int16_t target_torque;
         uint32_t digital_outputs;
+        uint16_t touch_probe;
+        int8_t mode_of_operation;
+        int8_t homing_method;
 
         int32_t previous_position;
         int32_t simulated_velocity;
@@ -39,12 +41,29 @@ namespace Sim
         uint16_t getErrorCode() const;
         uint32_t getDigitalInputs() const;
         bool getEmergencyStop() const;
+        uint16_t getTouchProbeStatus() const;
+        int32_t getTouchProbePosition() const;
+        int8_t getModeOfOperationDisplay() const;
 
         void setControlWord(uint16_t value);
         void setTargetPosition(int32_t value);
         void setTargetVelocity([[maybe_unused]] int32_t value){};
         void setTargetTorque([[maybe_unused]] int16_t value){};
         void setDigitalOutputs([[maybe_unused]] uint32_t value){};
+        void setTouchProbeFunction(uint16_t value)
+        {
+            touch_probe = value;
+        };
+        void setVelocityOffset([[maybe_unused]] int32_t value){};
+        void setTorqueOffset([[maybe_unused]] int16_t value){};
+        void setModeOfOperation(int8_t value)
+        {
+            mode_of_operation = value;
+        };
+        void setHomingMethod(int8_t value)
+        {
+            homing_method = value;
+        };
 
         void stepSimulation();
     };
@@ -0,0 +1,11 @@
+#include "statistics.hpp"
+
+void Drive::to_json(json &j, const Summary &p)
+{
+    j = json{{"mean", p.mean},
+             {"rms", p.rms},
+             {"min", p.min},
+             {"max", p.max},
+             {"peak", p.peak},
+             {"holdRms", p.holdRms}};
+}
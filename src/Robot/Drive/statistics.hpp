@@ -0,0 +1,170 @@
+#ifndef DRIVE_STATISTICS_HPP
+#define DRIVE_STATISTICS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+
+namespace Drive
+{
+    using json = nlohmann::json;
+
+    struct Summary
+    {
+        double mean;
+        double rms;
+        double min;
+        double max;
+        double peak;    // Largest magnitude since the last hold
+        double holdRms; // RMS since the last hold
+    };
+    void to_json(json &j, const Summary &p);
+
+    //! @brief Statistics over a sliding window of the last N samples
+    //!
+    //! Samples go into a fixed ring buffer and the sums are updated as samples enter and leave the
+    //! window, the minimum and maximum are the fronts of monotonic wedges over the window. Every
+    //! update is O(1), amortised for the wedges, and nothing is allocated. The peak and RMS since
+    //! the last hold cover a whole move instead of the window.
+    template <size_t N> class WindowStatistics
+    {
+      public:
+        void push(double value)
+        {
+            if (count == N)
+            {
+                auto old = samples[next];
+                sum -= old;
+                squares -= old * old;
+            }
+            else
+            {
+                count++;
+            }
+            samples[next] = value;
+            next = (next + 1) % N;
+            sum += value;
+            squares += value * value;
+
+            maxima.push(sequence, value);
+            minima.push(sequence, -value);
+            sequence++;
+
+            peak = std::max(peak, std::abs(value));
+            holdSquares += value * value;
+            holdCount++;
+        }
+
+        //! @brief Start the peak and RMS of a new move
+        void hold()
+        {
+            peak = 0;
+            holdSquares = 0;
+            holdCount = 0;
+        }
+
+        void clear()
+        {
+            count = 0;
+            next = 0;
+            sum = 0;
+            squares = 0;
+            maxima.clear();
+            minima.clear();
+            hold();
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        double mean() const
+        {
+            return count > 0 ? sum / count : 0;
+        }
+
+        double rms() const
+        {
+            // The running sum of squares can drift a hair below zero
+            return count > 0 ? std::sqrt(std::max(squares / count, 0.0)) : 0;
+        }
+
+        double min() const
+        {
+            return count > 0 ? -minima.front() : 0;
+        }
+
+        double max() const
+        {
+            return count > 0 ? maxima.front() : 0;
+        }
+
+        Summary summary() const
+        {
+            return {
+                .mean = mean(),
+                .rms = rms(),
+                .min = min(),
+                .max = max(),
+                .peak = peak,
+                .holdRms = holdCount > 0 ? std::sqrt(holdSquares / holdCount) : 0,
+            };
+        }
+
+      private:
+        //! @brief Decreasing values of the window with the sample they came from
+        struct Wedge
+        {
+            std::array<double, N> values;
+            std::array<uint64_t, N> sequences;
+            size_t head = 0;
+            size_t size = 0;
+
+            void push(uint64_t sequence, double value)
+            {
+                // Drop the sample leaving the window first so the new one always fits
+                if (size > 0 && sequences[head] + N <= sequence)
+                {
+                    head = (head + 1) % N;
+                    size--;
+                }
+                while (size > 0 && values[(head + size - 1) % N] <= value)
+                {
+                    size--;
+                }
+                values[(head + size) % N] = value;
+                sequences[(head + size) % N] = sequence;
+                size++;
+            }
+
+            double front() const
+            {
+                return values[head];
+            }
+
+            void clear()
+            {
+                head = 0;
+                size = 0;
+            }
+        };
+
+        std::array<double, N> samples;
+        size_t count = 0;
+        size_t next = 0;
+        uint64_t sequence = 0;
+        double sum = 0;
+        double squares = 0;
+        Wedge maxima;
+        Wedge minima;
+        double peak = 0;
+        double holdSquares = 0;
+        size_t holdCount = 0;
+    };
+} // namespace Drive
+
+#endif
@@ -0,0 +1,52 @@
+#include <cmath>
+
+#include "collision.hpp"
+
+void Dynamics::to_json(json &j, const CollisionSettings &s)
+{
+    j = json{{"enabled", s.enabled}, {"bandwidth", s.bandwidth}, {"thresholds", s.thresholds}};
+}
+
+void Dynamics::from_json(const json &j, CollisionSettings &s)
+{
+    s.enabled = j.value("enabled", true);
+    s.bandwidth = j.value("bandwidth", 50.0);
+    j.at("thresholds").get_to(s.thresholds);
+}
+
+//! @brief Clear the residual when the arm starts moving
+void Dynamics::CollisionDetector::reset()
+{
+    residual = {};
+    peak = {};
+}
+
+//! @brief Update the residual for one cycle
+//!
+//! @param expected Model torque in %
+//! @param measured Actual torque in %
+//! @param dt Cycle time in seconds
+//! @return Index of the first joint over its threshold or -1
+int Dynamics::CollisionDetector::update(const std::array<double, 4> &expected, const std::array<double, 4> &measured,
+                                        double dt)
+{
+    if (!settings.enabled)
+    {
+        return -1;
+    }
+
+    auto gain = 1 - std::exp(-2 * M_PI * settings.bandwidth * dt);
+    auto joint = -1;
+    for (size_t i = 0; i < 4; i++)
+    {
+        residual[i] += gain * (measured[i] - expected[i] - residual[i]);
+        peak[i] = std::max(peak[i], std::abs(residual[i]));
+        auto threshold = settings.thresholds[i] * scale[i];
+        if (joint < 0 && threshold > 0 && std::abs(residual[i]) > threshold)
+        {
+            joint = i;
+        }
+    }
+
+    return joint;
+}
@@ -0,0 +1,39 @@
+#ifndef DYNAMICS_COLLISION_HPP
+#define DYNAMICS_COLLISION_HPP
+
+#include <array>
+
+#include "nlohmann/json.hpp"
+
+namespace Dynamics
+{
+    using json = nlohmann::json;
+
+    struct CollisionSettings
+    {
+        bool enabled;
+        double bandwidth;                 // Hz of the residual filter
+        std::array<double, 4> thresholds; // % torque of residual per joint
+    };
+    void to_json(json &j, const CollisionSettings &s);
+    void from_json(const json &j, CollisionSettings &s);
+
+    //! @brief Torque residual collision detector
+    //!
+    //! The residual is the measured joint torque minus the torque the model expects for the
+    //! commanded trajectory, passed through a first order filter so the bandwidth trades noise for
+    //! detection delay. Any joint over its threshold is a collision.
+    class CollisionDetector
+    {
+      public:
+        CollisionSettings settings = {.enabled = false, .bandwidth = 50, .thresholds = {20, 20, 20, 20}};
+        std::array<double, 4> residual = {};
+        std::array<double, 4> peak = {};         // Largest residual since the last reset
+        std::array<double, 4> scale = {1, 1, 1, 1}; // Applied to the thresholds for the payload held
+
+        void reset();
+        int update(const std::array<double, 4> &expected, const std::array<double, 4> &measured, double dt);
+    };
+} // namespace Dynamics
+
+#endif
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cmath>
+
+#include "identification.hpp"
+
+void Dynamics::to_json(json &j, const ExcitationSettings &s)
+{
+    j = json{{"center", s.center},
+             {"amplitude", s.amplitude},
+             {"period", s.period},
+             {"harmonics", s.harmonics},
+             {"periods", s.periods}};
+}
+
+void Dynamics::from_json(const json &j, ExcitationSettings &s)
+{
+    j.at("center").get_to(s.center);
+    j.at("amplitude").get_to(s.amplitude);
+    s.period = j.value("period", 10.0);
+    s.harmonics = j.value("harmonics", size_t(5));
+    s.periods = j.value("periods", size_t(4));
+}
+
+void Dynamics::to_json(json &j, const JointFit &p)
+{
+    j = json{{"valid", p.valid},
+             {"inertia", p.inertia},
+             {"viscous", p.viscous},
+             {"coulomb", p.coulomb},
+             {"r2", p.r2},
+             {"rms", p.rms},
+             {"deviation", p.deviation}};
+}
+
+void Dynamics::to_json(json &j, const Identification &p)
+{
+    j = json{{"samples", p.samples}, {"joints", p.joints}, {"parameters", p.parameters}};
+}
+
+namespace
+{
+    //! @brief Sum of 1/k over the harmonics, scales the series to the amplitude
+    double harmonicSum(size_t harmonics)
+    {
+        auto sum = 0.0;
+        for (size_t k = 1; k <= harmonics; k++)
+        {
+            sum += 1.0 / k;
+        }
+        return std::max(sum, 1e-9);
+    }
+
+    //! @brief Solve the 3x3 normal equations
+    //!
+    //! @return False if the regressors are too close to collinear to separate the parameters
+    bool invert(const std::array<std::array<double, 3>, 3> &m, std::array<std::array<double, 3>, 3> &inverse)
+    {
+        auto det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                   m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                   m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        // Relative to the diagonal so the check doesn't depend on the units of the regressors
+        auto scale = m[0][0] * m[1][1] * m[2][2];
+        if (scale <= 0 || det <= 1e-9 * scale)
+        {
+            return false;
+        }
+
+        for (size_t r = 0; r < 3; r++)
+        {
+            for (size_t c = 0; c < 3; c++)
+            {
+                auto r1 = (c + 1) % 3, r2 = (c + 2) % 3;
+                auto c1 = (r + 1) % 3, c2 = (r + 2) % 3;
+                inverse[r][c] = (m[r1][c1] * m[r2][c2] - m[r1][c2] * m[r2][c1]) / det;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+//! @brief Length of the trajectory including the fade in and out
+double Dynamics::Excitation::duration() const
+{
+    return (settings.periods + 2) * settings.period;
+}
+
+//! @brief Setpoint of the excitation
+//!
+//! @param time Seconds since the start
+void Dynamics::Excitation::evaluate(double time, std::array<double, 4> &position, std::array<double, 4> &velocity,
+                                    std::array<double, 4> &acceleration) const
+{
+    const auto H = settings.harmonics;
+    const auto w = 2 * M_PI / settings.period;
+    const auto fade = settings.period;
+    const auto end = duration();
+    time = std::clamp(time, 0.0, end);
+
+    // Quintic envelope and its derivatives, flat in between the fades
+    auto e = 1.0, de = 0.0, dde = 0.0;
+    auto s = std::min(time, end - time) / fade;
+    if (s < 1)
+    {
+        auto sign = time < fade ? 1 : -1;
+        e = s * s * s * (10 - 15 * s + 6 * s * s);
+        de = sign * 30 * s * s * (1 - s) * (1 - s) / fade;
+        dde = 60 * s * (1 - s) * (1 - 2 * s) / (fade * fade);
+    }
+
+    auto norm = harmonicSum(H);
+    for (size_t i = 0; i < 4; i++)
+    {
+        auto f = 0.0, df = 0.0, ddf = 0.0;
+        for (size_t k = 1; k <= H; k++)
+        {
+            auto phase = M_PI * k * (k - 1) / H + M_PI * i * k / 4;
+            auto angle = k * w * time + phase;
+            f += sin(angle) / k;
+            df += w * cos(angle);
+            ddf -= k * w * w * sin(angle);
+        }
+        auto a = settings.amplitude[i] / norm;
+        f *= a;
+        df *= a;
+        ddf *= a;
+
+        position[i] = settings.center[i] + e * f;
+        velocity[i] = de * f + e * df;
+        acceleration[i] = dde * f + 2 * de * df + e * ddf;
+    }
+}
+
+//! @brief Upper bound of the velocity per joint
+std::array<double, 4> Dynamics::Excitation::peakVelocity() const
+{
+    const auto H = settings.harmonics;
+    const auto w = 2 * M_PI / settings.period;
+    const auto fade = settings.period;
+    auto norm = harmonicSum(H);
+
+    std::array<double, 4> peak;
+    for (size_t i = 0; i < 4; i++)
+    {
+        auto a = std::abs(settings.amplitude[i]);
+        peak[i] = 1.875 / fade * a + a * w * H / norm;
+    }
+    return peak;
+}
+
+//! @brief Upper bound of the acceleration per joint
+std::array<double, 4> Dynamics::Excitation::peakAcceleration() const
+{
+    const auto H = settings.harmonics;
+    const auto w = 2 * M_PI / settings.period;
+    const auto fade = settings.period;
+    auto norm = harmonicSum(H);
+
+    std::array<double, 4> peak;
+    for (size_t i = 0; i < 4; i++)
+    {
+        auto a = std::abs(settings.amplitude[i]);
+        peak[i] = 5.774 / (fade * fade) * a + 2 * 1.875 / fade * a * w * H / norm +
+                  a * w * w * H * (H + 1) / 2 / norm;
+    }
+    return peak;
+}
+
+//! @brief Fit inertia, viscous and coulomb friction per joint to a recorded excitation
+//!
+//! The rigid body torque of the links and z axis is taken from the model, the rest of the
+//! measured torque is regressed on acceleration, velocity and the smoothed sign of velocity by
+//! least squares. Acceleration is the central difference of the measured velocity over ±5
+//! cycles, which also low passes it. The standard deviation of every parameter follows from the
+//! residual variance and the inverse of the normal matrix.
+//!
+//! @param parameters Current model, its rigid body part is kept
+//! @param samples Recording at the cycle time
+//! @param dt Cycle time in seconds
+//! @param excited Joints which moved during the recording
+Dynamics::Identification Dynamics::identify(const Parameters &parameters, const std::vector<Sample> &samples,
+                                            double dt, const std::array<bool, 4> &excited)
+{
+    const size_t Window = 5;
+    const auto k = M_PI / 180;
+
+    Identification result = {.samples = samples.size(), .joints = {}, .parameters = parameters};
+
+    Model rigid;
+    rigid.parameters = parameters;
+    rigid.parameters.inertia = {};
+    rigid.parameters.viscous = {};
+    rigid.parameters.coulomb = {};
+
+    // Normal equations and torque sums per joint
+    std::array<std::array<std::array<double, 3>, 3>, 4> xx = {};
+    std::array<std::array<double, 3>, 4> xy = {};
+    std::array<double, 4> yy = {}, tt = {}, t = {};
+    size_t n = 0;
+
+    for (size_t s = Window; s + Window < samples.size(); s++)
+    {
+        const auto &sample = samples[s];
+        std::array<double, 4> acceleration;
+        for (size_t i = 0; i < 4; i++)
+        {
+            acceleration[i] = (samples[s + Window].velocity[i] - samples[s - Window].velocity[i]) / (2 * Window * dt);
+        }
+        auto model = rigid.torque(sample.position, sample.velocity, acceleration);
+
+        for (size_t i = 0; i < 4; i++)
+        {
+            auto rated = parameters.ratedTorque[i] / 100;
+            auto measured = sample.torque[i] * rated; // Nm
+            auto y = measured - model[i] * rated;
+            std::array<double, 3> x = {acceleration[i] * k, sample.velocity[i] * k,
+                                       std::tanh(sample.velocity[i] / std::max(parameters.coulombVelocity, 1e-3))};
+            for (size_t r = 0; r < 3; r++)
+            {
+                for (size_t c = 0; c < 3; c++)
+                {
+                    xx[i][r][c] += x[r] * x[c];
+                }
+                xy[i][r] += x[r] * y;
+            }
+            yy[i] += y * y;
+            tt[i] += measured * measured;
+            t[i] += measured;
+        }
+        n++;
+    }
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        auto &fit = result.joints[i];
+        std::array<std::array<double, 3>, 3> inverse;
+        if (!excited[i] || n <= 3 || parameters.ratedTorque[i] <= 0 || !invert(xx[i], inverse))
+        {
+            continue;
+        }
+
+        std::array<double, 3> theta = {};
+        for (size_t r = 0; r < 3; r++)
+        {
+            for (size_t c = 0; c < 3; c++)
+            {
+                theta[r] += inverse[r][c] * xy[i][c];
+            }
+        }
+
+        // Residual sum of squares from the normal equations, |y - Xθ|² = y·y - θ·Xᵀy
+        auto rss = yy[i];
+        for (size_t r = 0; r < 3; r++)
+        {
+            rss -= theta[r] * xy[i][r];
+        }
+        rss = std::max(rss, 0.0);
+        auto tss = tt[i] - t[i] * t[i] / n;
+        auto variance = rss / (n - 3);
+
+        fit.inertia = theta[0];
+        fit.viscous = theta[1];
+        fit.coulomb = theta[2];
+        fit.r2 = tss > 0 ? 1 - rss / tss : 0;
+        fit.rms = std::sqrt(rss / n) / parameters.ratedTorque[i] * 100;
+        for (size_t r = 0; r < 3; r++)
+        {
+            auto deviation = std::sqrt(std::max(variance * inverse[r][r], 0.0));
+            fit.deviation[r] = std::abs(theta[r]) > 0 ? deviation / std::abs(theta[r]) * 100 : INFINITY;
+        }
+        fit.valid = theta[0] >= 0 && theta[1] >= 0 && theta[2] >= 0;
+
+        if (fit.valid)
+        {
+            result.parameters.inertia[i] = fit.inertia;
+            result.parameters.viscous[i] = fit.viscous;
+            result.parameters.coulomb[i] = fit.coulomb;
+        }
+    }
+
+    return result;
+}
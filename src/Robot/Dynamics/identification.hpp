@@ -0,0 +1,75 @@
+#ifndef DYNAMICS_IDENTIFICATION_HPP
+#define DYNAMICS_IDENTIFICATION_HPP
+
+#include <array>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "model.hpp"
+
+namespace Dynamics
+{
+    using json = nlohmann::json;
+
+    struct ExcitationSettings
+    {
+        std::array<double, 4> center;    // Joint position the excitation oscillates about in degrees
+        std::array<double, 4> amplitude; // Largest excursion from the center in degrees, 0 keeps a joint still
+        double period;                   // s, fundamental of the Fourier series
+        size_t harmonics;
+        size_t periods; // Fundamental periods recorded between the fade in and out
+    };
+    void to_json(json &j, const ExcitationSettings &s);
+    void from_json(const json &j, ExcitationSettings &s);
+
+    //! @brief Band limited excitation trajectory
+    //!
+    //! Every joint follows a sum of harmonics of the fundamental with Schroeder phases, shifted per
+    //! joint so the joints don't move in step. A quintic envelope fades the series in and out over
+    //! one period so the trajectory starts and ends at the center at rest.
+    class Excitation
+    {
+      public:
+        ExcitationSettings settings = {};
+
+        double duration() const;
+        void evaluate(double time, std::array<double, 4> &position, std::array<double, 4> &velocity,
+                      std::array<double, 4> &acceleration) const;
+        std::array<double, 4> peakVelocity() const;
+        std::array<double, 4> peakAcceleration() const;
+    };
+
+    //! @brief Measurement of one control cycle
+    struct Sample
+    {
+        std::array<double, 4> position; // degrees
+        std::array<double, 4> velocity; // degrees/s
+        std::array<double, 4> torque;   // %
+    };
+
+    struct JointFit
+    {
+        bool valid; // Excited, well conditioned and physically plausible
+        double inertia;
+        double viscous;
+        double coulomb;
+        double r2;                       // Share of the measured torque variance explained by the model
+        double rms;                      // Residual in % torque
+        std::array<double, 3> deviation; // Standard deviation of inertia, viscous and coulomb in % of the value
+    };
+    void to_json(json &j, const JointFit &p);
+
+    struct Identification
+    {
+        size_t samples;
+        std::array<JointFit, 4> joints;
+        Parameters parameters; // Model with the valid fits applied
+    };
+    void to_json(json &j, const Identification &p);
+
+    Identification identify(const Parameters &parameters, const std::vector<Sample> &samples, double dt,
+                            const std::array<bool, 4> &excited);
+} // namespace Dynamics
+
+#endif
@@ -0,0 +1,121 @@
+#include <cmath>
+
+#include "../IK/scara.hpp"
+#include "model.hpp"
+
+void Dynamics::to_json(json &j, const Parameters &p)
+{
+    j = json{{"linkMass", p.linkMass},
+             {"linkCenter", p.linkCenter},
+             {"linkInertia", p.linkInertia},
+             {"zMass", p.zMass},
+             {"payload", p.payload},
+             {"inertia", p.inertia},
+             {"viscous", p.viscous},
+             {"coulomb", p.coulomb},
+             {"coulombVelocity", p.coulombVelocity},
+             {"ratedTorque", p.ratedTorque}};
+}
+
+void Dynamics::from_json(const json &j, Parameters &p)
+{
+    j.at("linkMass").get_to(p.linkMass);
+    j.at("linkCenter").get_to(p.linkCenter);
+    j.at("linkInertia").get_to(p.linkInertia);
+    j.at("zMass").get_to(p.zMass);
+    p.payload = j.value("payload", 0.0);
+    p.inertia = j.value("inertia", std::array<double, 4>{0, 0, 0, 0});
+    p.viscous = j.value("viscous", std::array<double, 4>{0, 0, 0, 0});
+    p.coulomb = j.value("coulomb", std::array<double, 4>{0, 0, 0, 0});
+    p.coulombVelocity = j.value("coulombVelocity", 1.0);
+    j.at("ratedTorque").get_to(p.ratedTorque);
+}
+
+//! @brief Joint torques needed to follow the trajectory
+//!
+//! The planar links give the inertia and Coriolis terms on the first two joints, the ball screw
+//! spline turns the z force of gravity and acceleration into torque on the third and fourth joint.
+//! Coulomb friction is smoothed with tanh so the torque doesn't step when a joint reverses.
+//!
+//! @param position Joint positions in degrees
+//! @param velocity Joint velocities in degrees/s
+//! @param acceleration Joint accelerations in degrees/s²
+//! @return Torque per joint in % of the rated torque
+std::array<double, 4> Dynamics::Model::torque(const std::array<double, 4> &position,
+                                              const std::array<double, 4> &velocity,
+                                              const std::array<double, 4> &acceleration) const
+{
+    const auto k = M_PI / 180;
+    const auto &p = parameters;
+
+    std::array<double, 4> v, a;
+    for (size_t i = 0; i < 4; i++)
+    {
+        v[i] = velocity[i] * k;
+        a[i] = acceleration[i] * k;
+    }
+
+    // Link geometry in metres, the z axis and payload sit at the tip of the second link
+    auto l1 = IK::L1 / 1000;
+    auto l2 = IK::L2 / 1000;
+    auto c1 = p.linkCenter[0] / 1000;
+    auto c2 = p.linkCenter[1] / 1000;
+    auto tip = p.zMass + p.payload;
+    auto cb = cos(position[1] * k);
+    auto sb = sin(position[1] * k);
+
+    auto m11 = p.linkInertia[0] + p.linkMass[0] * c1 * c1 + p.linkInertia[1] +
+               p.linkMass[1] * (l1 * l1 + c2 * c2 + 2 * l1 * c2 * cb) + tip * (l1 * l1 + l2 * l2 + 2 * l1 * l2 * cb);
+    auto m12 = p.linkInertia[1] + p.linkMass[1] * (c2 * c2 + l1 * c2 * cb) + tip * (l2 * l2 + l1 * l2 * cb);
+    auto m22 = p.linkInertia[1] + p.linkMass[1] * c2 * c2 + tip * l2 * l2;
+    auto h = (p.linkMass[1] * c2 + tip * l2) * l1 * sb;
+
+    std::array<double, 4> torque;
+    torque[0] = m11 * a[0] + m12 * a[1] - h * (2 * v[0] * v[1] + v[1] * v[1]);
+    torque[1] = m12 * a[0] + m22 * a[1] + h * v[0] * v[0];
+
+    // z = (theta - phi) * ScrewPitch, so the screw force acts on both joints with opposite sign
+    auto lead = IK::ScrewPitch / 1000 / k; // m/rad
+    auto force = tip * (Gravity + (a[2] - a[3]) * lead);
+    torque[2] = force * lead;
+    torque[3] = -force * lead;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        torque[i] += p.inertia[i] * a[i] + p.viscous[i] * v[i] +
+                     p.coulomb[i] * std::tanh(velocity[i] / std::max(p.coulombVelocity, 1e-3));
+        torque[i] = p.ratedTorque[i] > 0 ? torque[i] / p.ratedTorque[i] * 100 : 0;
+    }
+
+    return torque;
+}
+
+//! @brief Torque one kilogram of payload adds to the model torque
+//!
+//! The payload only enters the model as a point mass at the tip, so the torque is affine in it.
+//!
+//! @return Torque per joint in % of the rated torque per kg
+std::array<double, 4> Dynamics::Model::payloadTorque(const std::array<double, 4> &position,
+                                                     const std::array<double, 4> &velocity,
+                                                     const std::array<double, 4> &acceleration) const
+{
+    Model unit;
+    unit.parameters = {.payload = 1, .coulombVelocity = 1, .ratedTorque = parameters.ratedTorque};
+    return unit.torque(position, velocity, acceleration);
+}
+
+//! @brief Diagonal of the mass matrix at a position
+//!
+//! @return Torque per joint in % of the rated torque per degree/s² of that joint alone
+std::array<double, 4> Dynamics::Model::inertia(const std::array<double, 4> &position) const
+{
+    std::array<double, 4> zero = {}, result;
+    auto still = torque(position, zero, zero);
+    for (size_t i = 0; i < 4; i++)
+    {
+        auto acceleration = zero;
+        acceleration[i] = 1;
+        result[i] = torque(position, zero, acceleration)[i] - still[i];
+    }
+    return result;
+}
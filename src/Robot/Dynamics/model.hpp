@@ -0,0 +1,51 @@
+#ifndef DYNAMICS_MODEL_HPP
+#define DYNAMICS_MODEL_HPP
+
+#include <array>
+
+#include "nlohmann/json.hpp"
+
+namespace Dynamics
+{
+    using json = nlohmann::json;
+
+    const auto Gravity = 9.81; // m/s²
+
+    //! @brief Rigid body parameters of the arm
+    //!
+    //! The z axis and payload are lumped into a point mass at the end of the second link, lengths
+    //! follow the kinematics in mm and everything else is SI at the joint output.
+    struct Parameters
+    {
+        std::array<double, 2> linkMass;    // kg
+        std::array<double, 2> linkCenter;  // mm from the joint to the link centre of mass
+        std::array<double, 2> linkInertia; // kg·m² about the link centre of mass
+        double zMass;                      // kg moved by the ball screw, including the second link tip
+        double payload;                    // kg
+        std::array<double, 4> inertia;     // kg·m² reflected rotor and gear inertia per joint
+        std::array<double, 4> viscous;     // Nm/(rad/s) per joint
+        std::array<double, 4> coulomb;     // Nm per joint
+        double coulombVelocity;            // deg/s over which coulomb friction changes sign
+        std::array<double, 4> ratedTorque; // Nm at the joint output for 100 % drive torque
+    };
+    void to_json(json &j, const Parameters &p);
+    void from_json(const json &j, Parameters &p);
+
+    //! @brief Inverse dynamics of the SCARA
+    //!
+    //! Evaluated every cycle from the trajectory, the evaluation only uses the stack.
+    class Model
+    {
+      public:
+        Parameters parameters = {};
+
+        std::array<double, 4> torque(const std::array<double, 4> &position, const std::array<double, 4> &velocity,
+                                     const std::array<double, 4> &acceleration) const;
+        std::array<double, 4> payloadTorque(const std::array<double, 4> &position,
+                                            const std::array<double, 4> &velocity,
+                                            const std::array<double, 4> &acceleration) const;
+        std::array<double, 4> inertia(const std::array<double, 4> &position) const;
+    };
+} // namespace Dynamics
+
+#endif
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cmath>
+
+#include "payload.hpp"
+
+void Dynamics::to_json(json &j, const PayloadSettings &s)
+{
+    j = json{{"enabled", s.enabled},
+             {"reference", s.reference},
+             {"tolerance", s.tolerance},
+             {"window", s.window},
+             {"maxScale", s.maxScale},
+             {"minThreshold", s.minThreshold}};
+}
+
+void Dynamics::from_json(const json &j, PayloadSettings &s)
+{
+    s.enabled = j.value("enabled", true);
+    j.at("reference").get_to(s.reference);
+    s.tolerance = j.value("tolerance", 0.05);
+    s.window = j.value("window", 2.0);
+    s.maxScale = std::max(j.value("maxScale", 2.0), 1.0);
+    s.minThreshold = std::clamp(j.value("minThreshold", 0.5), 0.0, 1.0);
+}
+
+//! @brief Start estimating a new payload, right after a grip
+void Dynamics::PayloadEstimator::reset()
+{
+    phiphi = 0;
+    phiy = 0;
+    yy = 0;
+    equations = 0;
+    active = settings.enabled;
+    converged = false;
+    mass = settings.reference;
+    deviation = INFINITY;
+}
+
+//! @brief Use a known payload, 0 after a release
+void Dynamics::PayloadEstimator::set(double known)
+{
+    active = false;
+    converged = true;
+    mass = known;
+    deviation = 0;
+}
+
+//! @brief Add one cycle to the estimate
+//!
+//! @param expected Model torque in %
+//! @param measured Actual torque in %
+//! @param regressor Torque in % one kilogram of payload adds to the model torque
+//! @param modelMass Payload in the model that gave the expected torque in kg
+//! @param dt Cycle time in seconds
+void Dynamics::PayloadEstimator::update(const std::array<double, 4> &expected, const std::array<double, 4> &measured,
+                                        const std::array<double, 4> &regressor, double modelMass, double dt)
+{
+    if (!active)
+    {
+        return;
+    }
+
+    auto forget = std::exp(-dt / std::max(settings.window, dt));
+    phiphi *= forget;
+    phiy *= forget;
+    yy *= forget;
+    equations *= forget;
+    for (size_t i = 0; i < 4; i++)
+    {
+        // Residual of a model without payload
+        auto y = measured[i] - expected[i] + modelMass * regressor[i];
+        phiphi += regressor[i] * regressor[i];
+        phiy += regressor[i] * y;
+        yy += y * y;
+        equations++;
+    }
+    if (phiphi <= 0 || equations < 8)
+    {
+        return;
+    }
+
+    mass = phiy / phiphi;
+    auto variance = std::max(yy - mass * phiy, 0.0) / (equations - 1);
+    deviation = std::sqrt(variance / phiphi);
+    // Once good enough the estimate is applied, it keeps improving while the payload is held
+    converged = converged || deviation < settings.tolerance;
+}
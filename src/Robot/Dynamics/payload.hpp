@@ -0,0 +1,56 @@
+#ifndef DYNAMICS_PAYLOAD_HPP
+#define DYNAMICS_PAYLOAD_HPP
+
+#include <array>
+
+#include "nlohmann/json.hpp"
+
+namespace Dynamics
+{
+    using json = nlohmann::json;
+
+    struct PayloadSettings
+    {
+        bool enabled;
+        double reference;    // kg the active preset and collision thresholds were tuned for
+        double tolerance;    // kg, standard deviation below which the estimate is applied
+        double window;       // s, time constant over which old cycles are forgotten
+        double maxScale;     // Highest dynamics scale for a light payload
+        double minThreshold; // Smallest fraction of the collision thresholds for a light payload
+    };
+    void to_json(json &j, const PayloadSettings &s);
+    void from_json(const json &j, PayloadSettings &s);
+
+    //! @brief Recursive least squares estimate of the payload mass
+    //!
+    //! The model is affine in the payload, so the torque residual of every joint is the payload
+    //! error times the torque one kilogram would add. Each cycle adds four equations to the scalar
+    //! fit, the residual variance gives the standard deviation of the estimate.
+    class PayloadEstimator
+    {
+      public:
+        PayloadSettings settings = {.enabled = false,
+                                    .reference = 2,
+                                    .tolerance = 0.05,
+                                    .window = 2,
+                                    .maxScale = 2,
+                                    .minThreshold = 0.5};
+        bool active = false; // Estimating since the last grip
+        bool converged = false;
+        double mass = 0;      // kg
+        double deviation = 0; // kg
+
+        void reset();
+        void set(double known);
+        void update(const std::array<double, 4> &expected, const std::array<double, 4> &measured,
+                    const std::array<double, 4> &regressor, double modelMass, double dt);
+
+      private:
+        double phiphi = 0;
+        double phiy = 0;
+        double yy = 0;
+        double equations = 0;
+    };
+} // namespace Dynamics
+
+#endif
@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <cmath>
+
+#include "thermal.hpp"
+
+void Dynamics::to_json(json &j, const ThermalSettings &s)
+{
+    j = json{{"enabled", s.enabled},
+             {"timeConstant", s.timeConstant},
+             {"rated", s.rated},
+             {"limit", s.limit},
+             {"boost", s.boost}};
+}
+
+void Dynamics::from_json(const json &j, ThermalSettings &s)
+{
+    s.enabled = j.value("enabled", true);
+    j.at("timeConstant").get_to(s.timeConstant);
+    s.rated = j.value("rated", std::array<double, 4>{100, 100, 100, 100});
+    s.limit = j.value("limit", 1.0);
+    s.boost = std::max(j.value("boost", 1.0), 1.0);
+}
+
+//! @brief Heat the windings by one cycle
+//!
+//! @param torque Actual torque per motor in %
+//! @param dt Cycle time in seconds
+void Dynamics::ThermalModel::update(const std::array<double, 4> &torque, double dt)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        auto current = settings.rated[i] > 0 ? torque[i] / settings.rated[i] : 0;
+        auto tau = std::max(settings.timeConstant[i], dt);
+        load[i] += (current * current - load[i]) * dt / tau;
+        headroom[i] = settings.limit > 0 ? std::max(1 - load[i] / settings.limit, 0.0) : 0;
+    }
+}
+
+//! @brief Dynamics scale the motor can take with its current headroom
+//!
+//! @return Between 1 at the limit and the boost with a cold motor
+double Dynamics::ThermalModel::scale(size_t joint) const
+{
+    if (!settings.enabled)
+    {
+        return 1;
+    }
+    return 1 + (settings.boost - 1) * headroom[joint];
+}
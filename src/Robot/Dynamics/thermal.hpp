@@ -0,0 +1,44 @@
+#ifndef DYNAMICS_THERMAL_HPP
+#define DYNAMICS_THERMAL_HPP
+
+#include <array>
+
+#include "nlohmann/json.hpp"
+
+namespace Dynamics
+{
+    using json = nlohmann::json;
+
+    struct ThermalSettings
+    {
+        bool enabled;
+        std::array<double, 4> timeConstant; // s, winding thermal time constant per motor
+        std::array<double, 4> rated;        // % torque drawing the rated continuous current per motor
+        double limit;                       // Load at which no boost is left, 1 is the continuous rating
+        double boost;                       // Largest dynamics scale with a cold motor
+    };
+    void to_json(json &j, const ThermalSettings &s);
+    void from_json(const json &j, ThermalSettings &s);
+
+    //! @brief I²t model of the motor windings
+    //!
+    //! Torque is proportional to current so the square of torque over its rated value heats the
+    //! winding through a first order lag. A load of 1 is the steady state at rated current, the
+    //! headroom left below the limit lets the planner run above the continuous dynamics for a while.
+    class ThermalModel
+    {
+      public:
+        ThermalSettings settings = {.enabled = false,
+                                    .timeConstant = {60, 60, 30, 30},
+                                    .rated = {100, 100, 100, 100},
+                                    .limit = 1,
+                                    .boost = 1};
+        std::array<double, 4> load = {};
+        std::array<double, 4> headroom = {1, 1, 1, 1}; // Fraction of the limit left
+
+        void update(const std::array<double, 4> &torque, double dt);
+        double scale(size_t joint) const;
+    };
+} // namespace Dynamics
+
+#endif
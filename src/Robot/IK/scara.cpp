@@ -142,6 +142,62 @@ std::tuple<double, double, double, double, IK::Result> IK::postprocessing(double
     return {alpha, beta, theta, phi, result};
 }
 
+//! @brief Joint velocity for a cartesian velocity
+//!
+//! Inverts the Jacobian of the forward kinematics at the given arm configuration, angles are in
+//! degrees and velocities in mm/s and degrees/s.
+//!
+//! @param alpha Angle of the first joint
+//! @param beta Angle of the second joint
+//! @param r Tool rotation
+//! @return Joint velocities in the same order as inverseKinematics
+std::tuple<double, double, double, double, IK::Result> IK::jointVelocity(double alpha, double beta, double r,
+                                                                         double vx, double vy, double vz, double vr,
+                                                                         double toolOffset)
+{
+    const auto k = M_PI / 180;
+
+    // Remove the tool tip motion caused by rotation
+    vx -= toolOffset * cos(r * k) * vr * k;
+    vy += toolOffset * sin(r * k) * vr * k;
+
+    // The arm can't move radially when stretched out or folded back
+    auto sb = sin(beta * k);
+    if (std::abs(sb) < SingularSine)
+    {
+        return {0, 0, 0, 0, IK::Result::Singularity};
+    }
+
+    auto s1 = sin(alpha * k);
+    auto c1 = cos(alpha * k);
+    auto s12 = sin((alpha + beta) * k);
+    auto c12 = cos((alpha + beta) * k);
+    auto det = L1 * L2 * sb;
+
+    auto alphaVelocity = (L2 * c12 * vx + L2 * s12 * vy) / det / k;
+    auto betaVelocity = (-(L1 * c1 + L2 * c12) * vx - (L1 * s1 + L2 * s12) * vy) / det / k;
+    auto phiVelocity = (-1) * (alphaVelocity + betaVelocity + vr);
+    auto thetaVelocity = phiVelocity + vz / ScrewPitch;
+
+    return {alphaVelocity, betaVelocity, thetaVelocity, phiVelocity, IK::Result::Success};
+}
+
+//! @brief Clamp joint space targets to the same limits applied by inverse kinematics
+std::tuple<double, double, double, double, IK::Result> IK::jointLimits(double alpha, double beta, double theta,
+                                                                       double phi)
+{
+    IK::Result result = IK::Result::Success;
+
+    if (alpha < AlphaMin || alpha > AlphaMax || beta < BetaMin || beta > BetaMax)
+    {
+        result = IK::Result::JointLimit;
+    }
+    alpha = std::max(AlphaMin, std::min(AlphaMax, alpha));
+    beta = std::max(BetaMin, std::min(BetaMax, beta));
+
+    return {alpha, beta, theta, phi, result};
+}
+
 void IK::to_json(json &j, const Pose &p)
 {
     j = json{
@@ -158,6 +214,7 @@ void IK::to_json(json &j, const Pose &p)
         {"phiVelocity", p.phiVelocity},
         {"thetaVelocity", p.thetaVelocity},
         {"toolOffset", p.toolOffset},
+        {"space", p.space == Space::Joint ? "joint" : "cartesian"},
     };
 }
 void IK::from_json(const json &j, Pose &p)
@@ -173,6 +230,7 @@ void IK::from_json(const json &j, Pose &p)
     p.theta = j.value("theta", 0.0);
 
     p.toolOffset = j.value("toolOffset", 0.0);
+    p.space = j.value("space", "cartesian") == "joint" ? Space::Joint : Space::Cartesian;
 }
 
 std::string IK::resultToString(IK::Result result)
@@ -20,8 +20,19 @@ namespace IK
     const auto BetaMax = 150.0;          // Maximum angle of the second joint
     const auto BaseKeepOut = 100.0;      // Keep out distance from the base
     const auto BaseKeepOutBorder = 10.0; // Keep out distance from the base buffer
+    const auto SingularSine = 0.02;      // Sine of beta below which the arm is treated as stretched out
 
     using json = nlohmann::json;
+
+    //! @brief Coordinate space a pose is commanded in
+    //!
+    //! Joint space poses are fed to the OTG as is, cartesian poses go through inverse kinematics.
+    enum class Space
+    {
+        Cartesian,
+        Joint,
+    };
+
     struct Pose
     {
         double x, y, z, r;
@@ -29,6 +40,7 @@ namespace IK
         double toolOffset;
         double alphaVelocity, betaVelocity;
         double thetaVelocity, phiVelocity;
+        Space space = Space::Cartesian;
     };
     void to_json(json &j, const Pose &p);
     void from_json(const json &j, Pose &p);
@@ -47,9 +59,14 @@ namespace IK
                                                                  double toolOffset = 0);
     std::tuple<double, double, double, double, Result> inverseKinematics(double x, double y, double z, double r,
                                                                          double toolOffset = 0);
+    std::tuple<double, double, double, double, Result> jointVelocity(double alpha, double beta, double r, double vx,
+                                                                     double vy, double vz, double vr,
+                                                                     double toolOffset = 0);
     std::tuple<double, double, double, double, Result> preprocessing(double x, double y, double z, double r);
     std::tuple<double, double, double, double, Result> postprocessing(double alpha, double beta, double theta,
                                                                       double phi);
+    std::tuple<double, double, double, double, Result> jointLimits(double alpha, double beta, double theta,
+                                                                   double phi);
 
 } // namespace IK
 
@@ -0,0 +1,51 @@
+#include "motion.hpp"
+
+//! @brief Minimum jerk limited stopping distance of a single axis
+//!
+//! The fastest stop ramps acceleration down to the braking limit, holds it and ramps back to
+//! zero so velocity and acceleration reach zero together.
+//!
+//! @param velocity Current velocity
+//! @param acceleration Current acceleration
+//! @param maxAcceleration Braking acceleration limit
+//! @param maxJerk Jerk limit
+//! @return Signed distance travelled before coming to rest
+double Motion::brakingDistance(double velocity, double acceleration, double maxAcceleration, double maxJerk)
+{
+    if (velocity == 0 && acceleration == 0)
+    {
+        return 0;
+    }
+
+    // Mirror the problem so the axis is moving in the positive direction
+    auto sign = velocity < 0 ? -1.0 : 1.0;
+    auto v = velocity * sign;
+    auto a = acceleration * sign;
+    auto J = maxJerk;
+    double p = 0;
+
+    const auto ramp = [&](double jerk, double t) {
+        p += v * t + a * t * t / 2 + jerk * t * t * t / 6;
+        v += a * t + jerk * t * t / 2;
+        a += jerk * t;
+    };
+
+    // Already braking hard enough, releasing the brake brings the axis to rest
+    if (a < 0 && v <= a * a / (2 * J))
+    {
+        ramp(J, -a / J);
+        return p * sign;
+    }
+
+    // Peak braking acceleration, either the limit or the one where the ramps meet
+    auto peak = std::max(-std::sqrt(J * v + a * a / 2), -maxAcceleration);
+    peak = std::min(peak, std::max(a, -maxAcceleration));
+    if (a > peak)
+    {
+        ramp(-J, (a - peak) / J);
+    }
+    ramp(0, std::max(v - peak * peak / (2 * J), 0.0) / -peak);
+    ramp(J, -peak / J);
+
+    return p * sign;
+}
@@ -1,9 +1,10 @@
 #include "motion.hpp"
 
-std::tuple<std::deque<IK::Pose>, IK::Result> Motion::linearInterpolation(const IK::Pose &start, const IK::Pose &end,
-                                                                         double steps)
+std::tuple<Motion::Spline, IK::Result> Motion::linearInterpolation(const IK::Pose &start, const IK::Pose &end,
+                                                                   double steps, double tolerance)
 {
-    std::deque<IK::Pose> path;
+    std::vector<std::array<double, 4>> samples;
+    samples.reserve(size_t(std::max(steps, 0.0)) + 1);
 
     for (int i = 0; i < steps; i++)
     {
@@ -18,19 +19,28 @@ std::tuple<std::deque<IK::Pose>, IK::Result> Motion::linearInterpolation(const I
         if (result != IK::Result::Success)
         {
             spdlog::warn("Failed to interpolate: {}", resultToString(result));
-            return {path, result};
+            return {Spline{}, result};
         }
 
-        path.push_back({.x = x,
-                        .y = y,
-                        .z = z,
-                        .r = r,
-                        .alpha = alpha,
-                        .beta = beta,
-                        .theta = theta,
-                        .phi = phi,
-                        .toolOffset = toolOffset});
+        samples.push_back({alpha, beta, theta, phi});
     }
 
-    return {path, IK::Result::Success};
-}
\ No newline at end of file
+    auto spline = Spline::fit(samples, tolerance);
+    if (!samples.empty())
+    {
+        auto dt = (samples.size() - 1) / steps;
+        spline.end = {
+            .x = start.x + (end.x - start.x) * dt,
+            .y = start.y + (end.y - start.y) * dt,
+            .z = start.z + (end.z - start.z) * dt,
+            .r = start.r + (end.r - start.r) * dt,
+            .alpha = samples.back()[0],
+            .beta = samples.back()[1],
+            .theta = samples.back()[2],
+            .phi = samples.back()[3],
+            .toolOffset = start.toolOffset + (end.toolOffset - start.toolOffset) * dt,
+        };
+    }
+
+    return {spline, IK::Result::Success};
+}
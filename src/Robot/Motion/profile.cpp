@@ -0,0 +1,94 @@
+#include "profile.hpp"
+
+//! @brief Plan a rest to rest profile over a distance of one
+//!
+//! @param maxVelocity Velocity limit in distance per second
+//! @param maxAcceleration Acceleration limit in distance per second^2
+//! @param maxJerk Jerk limit in distance per second^3
+void Motion::SCurve::plan(double maxVelocity, double maxAcceleration, double maxJerk)
+{
+    const double L = 1.0;
+    auto v = maxVelocity, a = maxAcceleration, j = maxJerk;
+    double Tj = 0, Ta = 0, Tv = 0;
+
+    if (std::isfinite(v) && std::isfinite(a) && std::isfinite(j))
+    {
+        // Acceleration limit is not reached before the velocity limit
+        Tj = a / j;
+        if (v * j < a * a)
+        {
+            Tj = std::sqrt(v / j);
+            a = j * Tj;
+        }
+        Ta = v / a - Tj;
+
+        if (v * (2 * Tj + Ta) > L)
+        {
+            // Velocity limit is not reached, solve L = v * (v / a + Tj) for v
+            a = maxAcceleration;
+            Tj = a / j;
+            v = a / 2 * (-Tj + std::sqrt(Tj * Tj + 4 * L / a));
+            Ta = v / a - Tj;
+            if (Ta < 0)
+            {
+                // Neither acceleration nor velocity limit is reached
+                Tj = std::cbrt(L / (2 * j));
+                Ta = 0;
+            }
+        }
+        else
+        {
+            Tv = (L - v * (2 * Tj + Ta)) / v;
+        }
+    }
+    else
+    {
+        j = 0;
+    }
+
+    std::array<double, 7> phase = {Tj, Ta, Tj, Tv, Tj, Ta, Tj};
+    jerk = {j, 0, -j, 0, -j, 0, j};
+
+    start[0] = 0;
+    double p = 0, dp = 0, ddp = 0;
+    for (size_t k = 0; k < 7; k++)
+    {
+        position[k] = p;
+        velocity[k] = dp;
+        acceleration[k] = ddp;
+
+        auto t = phase[k];
+        p += dp * t + ddp * t * t / 2 + jerk[k] * t * t * t / 6;
+        dp += ddp * t + jerk[k] * t * t / 2;
+        ddp += jerk[k] * t;
+        start[k + 1] = start[k] + t;
+    }
+    duration = start[7];
+}
+
+//! @brief Plan a rest to rest profile over a distance of one that takes a given duration
+//!
+//! The minimum time profile is slowed down by lowering its cruise velocity while keeping the
+//! acceleration and jerk limits, the way Ruckig synchronises an axis that could arrive earlier.
+//!
+//! @param target Duration in seconds, the minimum time is kept if it is longer
+void Motion::SCurve::plan(double maxVelocity, double maxAcceleration, double maxJerk, double target)
+{
+    plan(maxVelocity, maxAcceleration, maxJerk);
+    if (duration >= target || !std::isfinite(maxJerk))
+    {
+        return;
+    }
+
+    // Duration with a cruise phase at velocity v, which shortens as v rises up to the peak velocity
+    // of the minimum time profile. The acceleration limit is reached above a^2 / j.
+    auto a = maxAcceleration, j = maxJerk;
+    auto time = [&](double v) { return v * j >= a * a ? 1 / v + v / a + a / j : 1 / v + 2 * std::sqrt(v / j); };
+    double low = 0, high = velocity[3];
+    for (size_t i = 0; i < 64; i++)
+    {
+        auto v = (low + high) / 2;
+        (time(v) > target ? low : high) = v;
+    }
+    plan(high, a, j);
+}
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <experimental/simd>
+
+#include "ruckig/ruckig.hpp"
+
+namespace Motion
+{
+    //! @brief Rest to rest jerk limited profile over a normalised distance of one
+    //!
+    //! Seven phases of constant jerk: jerk up, constant acceleration, jerk down, cruise and the mirror
+    //! image for deceleration. Phases collapse to zero length when a limit is not reached.
+    struct SCurve
+    {
+        std::array<double, 8> start;
+        std::array<double, 7> jerk;
+        std::array<double, 7> position, velocity, acceleration;
+        double duration;
+
+        void plan(double maxVelocity, double maxAcceleration, double maxJerk);
+        void plan(double maxVelocity, double maxAcceleration, double maxJerk, double target);
+    };
+
+    //! @brief Lightweight time synchronised OTG for targets at rest
+    //!
+    //! Restricted to the position interface with zero target velocity and acceleration, starting
+    //! from rest, with time synchronisation and symmetric limits. Every axis gets its own S-curve
+    //! over its distance. The slowest one sets the duration and the others cruise slower to arrive
+    //! with it, which gives the same duration as Ruckig. Each cycle evaluates all axes in one SIMD
+    //! pass, every lane picks the polynomial of the phase its axis is in.
+    template <size_t DOFs> class JerkProfile
+    {
+        using Lanes = std::experimental::fixed_size_simd<double, DOFs>;
+
+      public:
+        double delta_time;
+
+        explicit JerkProfile(double delta_time) : delta_time(delta_time)
+        {
+        }
+
+        void reset()
+        {
+            active = false;
+        }
+
+        double getDuration() const
+        {
+            return duration;
+        }
+
+        //! @brief Check if the profile can take over for the given input
+        bool accepts(const ruckig::InputParameter<DOFs> &input) const
+        {
+            if (input.control_interface != ruckig::ControlInterface::Position ||
+                input.synchronization != ruckig::Synchronization::Time ||
+                input.duration_discretization != ruckig::DurationDiscretization::Continuous ||
+                input.minimum_duration || input.min_velocity || input.min_acceleration || input.max_position ||
+                input.min_position)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < DOFs; i++)
+            {
+                if (input.target_velocity[i] != 0.0 || input.target_acceleration[i] != 0.0)
+                {
+                    return false;
+                }
+            }
+            if (active && input.target_position == target)
+            {
+                return true;
+            }
+            for (size_t i = 0; i < DOFs; i++)
+            {
+                if (std::abs(input.current_velocity[i]) > RestTolerance ||
+                    std::abs(input.current_acceleration[i]) > RestTolerance)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        ruckig::Result update(const ruckig::InputParameter<DOFs> &input, ruckig::OutputParameter<DOFs> &output)
+        {
+            output.new_calculation = false;
+            if (!active || input.target_position != target)
+            {
+                auto begin = std::chrono::steady_clock::now();
+                plan(input);
+                output.new_calculation = true;
+                output.calculation_duration =
+                    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+            }
+
+            time = std::min(time + delta_time, duration);
+            output.time = time;
+            if (time >= duration)
+            {
+                output.new_position = target;
+                output.new_velocity = {};
+                output.new_acceleration = {};
+                return ruckig::Result::Finished;
+            }
+
+            Lanes t = time;
+            auto begin = start[0], p = position[0], v = velocity[0], a = acceleration[0], j = jerk[0];
+            for (size_t k = 1; k < 7; k++)
+            {
+                auto entered = t >= start[k];
+                where(entered, begin) = start[k];
+                where(entered, p) = position[k];
+                where(entered, v) = velocity[k];
+                where(entered, a) = acceleration[k];
+                where(entered, j) = jerk[k];
+            }
+            auto dt = t - begin;
+            Lanes s = p + dt * (v + dt * (a / 2 + dt * j / 6));
+            Lanes ds = v + dt * (a + dt * j / 2);
+            Lanes dds = a + dt * j;
+
+            using std::experimental::element_aligned;
+            Lanes(origin + distance * s).copy_to(output.new_position.data(), element_aligned);
+            Lanes(distance * ds).copy_to(output.new_velocity.data(), element_aligned);
+            Lanes(distance * dds).copy_to(output.new_acceleration.data(), element_aligned);
+            return ruckig::Result::Working;
+        }
+
+        //! @brief Plan the move to the target of the input, update does so when the target changes
+        void plan(const ruckig::InputParameter<DOFs> &input)
+        {
+            // An axis already at its target divides to infinity and gets a curve of no duration
+            std::array<SCurve, DOFs> curves;
+            std::array<double, DOFs> from, span;
+            duration = 0;
+            for (size_t i = 0; i < DOFs; i++)
+            {
+                from[i] = input.current_position[i];
+                span[i] = input.target_position[i] - input.current_position[i];
+                auto d = std::abs(span[i]);
+                curves[i].plan(input.max_velocity[i] / d, input.max_acceleration[i] / d, input.max_jerk[i] / d);
+                duration = std::max(duration, curves[i].duration);
+            }
+            for (size_t i = 0; i < DOFs; i++)
+            {
+                auto d = std::abs(span[i]);
+                curves[i].plan(input.max_velocity[i] / d, input.max_acceleration[i] / d, input.max_jerk[i] / d,
+                               duration);
+                for (size_t k = 0; k < 7; k++)
+                {
+                    start[k][i] = curves[i].start[k];
+                    position[k][i] = curves[i].position[k];
+                    velocity[k][i] = curves[i].velocity[k];
+                    acceleration[k][i] = curves[i].acceleration[k];
+                    jerk[k][i] = curves[i].jerk[k];
+                }
+            }
+            origin.copy_from(from.data(), std::experimental::element_aligned);
+            distance.copy_from(span.data(), std::experimental::element_aligned);
+            target = input.target_position;
+            time = 0;
+            active = true;
+        }
+
+      private:
+        static constexpr double RestTolerance = 1e-9;
+
+        bool active = false;
+        double time = 0;
+        double duration = 0;
+        // Normalised curve of each axis by phase, one lane per axis
+        std::array<Lanes, 7> start, position, velocity, acceleration, jerk;
+        Lanes origin, distance;
+        std::array<double, DOFs> target = {};
+    };
+
+    //! @brief OTG backend selection
+    enum class Backend
+    {
+        Ruckig,
+        Profile,
+    };
+
+    //! @brief Common interface over Ruckig and the lightweight profile
+    //!
+    //! Drop in replacement for ruckig::Ruckig, the profile backend is only used while its
+    //! restrictions hold and anything else falls through to Ruckig from the current state.
+    template <size_t DOFs> class Generator
+    {
+      public:
+        ruckig::Ruckig<DOFs> ruckig;
+        JerkProfile<DOFs> profile;
+        Backend backend = Backend::Ruckig;
+
+        explicit Generator(double delta_time) : ruckig(delta_time), profile(delta_time)
+        {
+        }
+
+        void reset()
+        {
+            ruckig.reset();
+            profile.reset();
+            following = false;
+            planned = false;
+        }
+
+        //! @brief Plan a rest to rest move ahead of the cycle it starts in
+        //!
+        //! update takes the plan over instead of planning once its input asks for the same move from
+        //! rest at the same start, so the planning time falls into a cycle of the move before.
+        void preplan(const ruckig::InputParameter<DOFs> &input)
+        {
+            planned = false;
+            nextProfile.reset();
+            if (backend == Backend::Profile && nextProfile.accepts(input))
+            {
+                nextProfile.plan(input);
+                nextBackend = Backend::Profile;
+            }
+            else if (ruckig.calculate(input, nextTrajectory) >= 0)
+            {
+                nextBackend = Backend::Ruckig;
+            }
+            else
+            {
+                return;
+            }
+            next = input;
+            planned = true;
+        }
+
+        ruckig::Result update(const ruckig::InputParameter<DOFs> &input, ruckig::OutputParameter<DOFs> &output)
+        {
+            if (planned && adopts(input))
+            {
+                planned = false;
+                output.new_calculation = false;
+                if (nextBackend == Backend::Profile)
+                {
+                    std::swap(profile, nextProfile);
+                    following = false;
+                }
+                else
+                {
+                    profile.reset();
+                    output.trajectory = nextTrajectory;
+                    output.time = 0;
+                    followed = next.target_position;
+                    following = true;
+                }
+                active = nextBackend;
+            }
+
+            if (following && input.target_position == followed)
+            {
+                // Step the preplanned trajectory like Ruckig steps its own
+                output.new_calculation = false;
+                output.time = std::min(output.time + ruckig.delta_time, output.trajectory.get_duration());
+                output.trajectory.at_time(output.time, output.new_position, output.new_velocity,
+                                          output.new_acceleration);
+                return output.time >= output.trajectory.get_duration() ? ruckig::Result::Finished
+                                                                       : ruckig::Result::Working;
+            }
+
+            if (backend == Backend::Profile && profile.accepts(input))
+            {
+                following = false;
+                active = Backend::Profile;
+                return profile.update(input, output);
+            }
+
+            if (active == Backend::Profile || following)
+            {
+                // Ruckig picks up from the state the profile or the preplanned trajectory left behind
+                profile.reset();
+                ruckig.reset();
+                following = false;
+                active = Backend::Ruckig;
+            }
+            return ruckig.update(input, output);
+        }
+
+        Backend getActiveBackend() const
+        {
+            return active;
+        }
+
+        //! @brief Duration of the trajectory the output was sampled from
+        double getDuration(const ruckig::OutputParameter<DOFs> &output) const
+        {
+            return active == Backend::Profile ? profile.getDuration() : output.trajectory.get_duration();
+        }
+
+      private:
+        static constexpr double StartTolerance = 1e-6;
+
+        Backend active = Backend::Ruckig;
+        bool following = false; // Stepping the preplanned Ruckig trajectory in the output
+        std::array<double, DOFs> followed = {};
+
+        // Move planned ahead
+        bool planned = false;
+        Backend nextBackend = Backend::Ruckig;
+        ruckig::InputParameter<DOFs> next;
+        JerkProfile<DOFs> nextProfile{ruckig.delta_time};
+        ruckig::Trajectory<DOFs> nextTrajectory;
+
+        //! @brief Check if the input asks for the preplanned move
+        bool adopts(const ruckig::InputParameter<DOFs> &input) const
+        {
+            if (input.target_position != next.target_position || input.target_velocity != next.target_velocity ||
+                input.target_acceleration != next.target_acceleration || input.max_velocity != next.max_velocity ||
+                input.max_acceleration != next.max_acceleration || input.max_jerk != next.max_jerk ||
+                input.control_interface != next.control_interface || input.synchronization != next.synchronization)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < DOFs; i++)
+            {
+                if (std::abs(input.current_position[i] - next.current_position[i]) > StartTolerance ||
+                    std::abs(input.current_velocity[i]) > StartTolerance ||
+                    std::abs(input.current_acceleration[i]) > StartTolerance)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+} // namespace Motion
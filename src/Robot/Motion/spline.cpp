@@ -0,0 +1,167 @@
+#include "spline.hpp"
+
+namespace
+{
+    //! @brief Cubic Hermite segment between two samples
+    Motion::SplineSegment hermite(const std::vector<std::array<double, 4>> &samples,
+                                  const std::vector<std::array<double, 4>> &velocity, size_t first, size_t last)
+    {
+        Motion::SplineSegment segment = {.start = double(first), .coefficients = {}};
+        auto h = double(last - first);
+        auto &c = segment.coefficients;
+        for (size_t i = 0; i < 4; i++)
+        {
+            auto p0 = samples[first][i];
+            auto p1 = samples[last][i];
+            auto v0 = velocity[first][i];
+            auto v1 = velocity[last][i];
+            c[0][i] = p0;
+            c[1][i] = v0;
+            c[2][i] = (3 * (p1 - p0) - (2 * v0 + v1) * h) / (h * h);
+            c[3][i] = (2 * (p0 - p1) + (v0 + v1) * h) / (h * h * h);
+        }
+        return segment;
+    }
+
+    //! @brief Check that every sample covered by a segment is within tolerance
+    bool withinTolerance(const Motion::SplineSegment &segment, const std::vector<std::array<double, 4>> &samples,
+                         size_t first, size_t last, double tolerance)
+    {
+        auto &c = segment.coefficients;
+        for (auto k = first + 1; k < last; k++)
+        {
+            auto t = double(k - first);
+            for (size_t i = 0; i < 4; i++)
+            {
+                auto p = ((c[3][i] * t + c[2][i]) * t + c[1][i]) * t + c[0][i];
+                if (std::abs(p - samples[k][i]) > tolerance)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+} // namespace
+
+//! @brief Fit joint samples to a piecewise cubic spline
+//!
+//! Samples are assumed to be one cycle apart. Segments are grown exponentially from each knot
+//! and then bisected back to the longest span whose interior samples all stay within tolerance.
+//!
+//! @param samples Joint positions, one per cycle
+//! @param tolerance Maximum deviation from any sample in degrees
+//! @return The fitted spline
+Motion::Spline Motion::Spline::fit(const std::vector<std::array<double, 4>> &samples, double tolerance)
+{
+    Spline spline;
+    spline.length = samples.size();
+    auto n = samples.size();
+    if (n == 0)
+    {
+        return spline;
+    }
+
+    if (n == 1)
+    {
+        spline.segments.push_back({.start = 0, .coefficients = {samples[0]}});
+        return spline;
+    }
+
+    // Central difference velocity estimate in units per cycle
+    std::vector<std::array<double, 4>> velocity(n, {0.0, 0.0, 0.0, 0.0});
+    for (size_t k = 0; k < n; k++)
+    {
+        auto prev = k == 0 ? 0 : k - 1;
+        auto next = std::min(k + 1, n - 1);
+        for (size_t i = 0; i < 4; i++)
+        {
+            velocity[k][i] = (samples[next][i] - samples[prev][i]) / double(next - prev);
+        }
+    }
+
+    const auto fits = [&](size_t first, size_t last) {
+        return withinTolerance(hermite(samples, velocity, first, last), samples, first, last, tolerance);
+    };
+
+    size_t first = 0;
+    while (first < n - 1)
+    {
+        // A single interval has no interior samples and always fits
+        auto good = first + 1;
+        auto bad = n;
+        for (size_t span = 2; first + span < n; span *= 2)
+        {
+            if (!fits(first, first + span))
+            {
+                bad = first + span;
+                break;
+            }
+            good = first + span;
+        }
+        if (bad == n && good < n - 1)
+        {
+            if (fits(first, n - 1))
+            {
+                good = n - 1;
+            }
+            else
+            {
+                bad = n - 1;
+            }
+        }
+        while (bad != n && bad - good > 1)
+        {
+            auto mid = good + (bad - good) / 2;
+            if (fits(first, mid))
+            {
+                good = mid;
+            }
+            else
+            {
+                bad = mid;
+            }
+        }
+
+        spline.segments.push_back(hermite(samples, velocity, first, good));
+        first = good;
+    }
+
+    return spline;
+}
+
+//! @brief Evaluate the spline at a cycle
+//!
+//! The segment index is advanced monotonically by the caller so lookup is O(1) while following
+//! the path, evaluation itself is a fixed Horner step across all axes.
+//!
+//! @param cycle Cycles elapsed since the start of the spline
+//! @param segment Segment cursor, zero on the first call
+//! @param position Evaluated joint positions
+//! @return False once the cycle is past the end of the spline
+bool Motion::Spline::evaluate(size_t cycle, size_t &segment, std::array<double, 4> &position) const
+{
+    if (cycle >= length)
+    {
+        return false;
+    }
+    while (segment + 1 < segments.size() && cycle >= segments[segment + 1].start)
+    {
+        segment++;
+    }
+
+    const auto &c = segments[segment].coefficients;
+    auto t = double(cycle) - segments[segment].start;
+    for (size_t i = 0; i < 4; i++)
+    {
+        position[i] = ((c[3][i] * t + c[2][i]) * t + c[1][i]) * t + c[0][i];
+    }
+
+    return true;
+}
+
+//! @brief Approximate memory used by the spline in bytes
+size_t Motion::Spline::memory() const
+{
+    return sizeof(Spline) + segments.capacity() * sizeof(SplineSegment);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "../IK/scara.hpp"
+
+namespace Motion
+{
+    //! @brief Cubic segment of a joint space spline
+    //!
+    //! Coefficients are stored as [power][axis] so all four axes are evaluated together, the
+    //! polynomial variable is the number of cycles elapsed since the start knot.
+    struct SplineSegment
+    {
+        double start;
+        std::array<std::array<double, 4>, 4> coefficients;
+    };
+
+    //! @brief Piecewise cubic joint space trajectory
+    //!
+    //! Replaces a sample per cycle with a list of knots fitted within a tolerance, a path of a few
+    //! minutes compresses down to a few hundred segments.
+    class Spline
+    {
+      public:
+        std::vector<SplineSegment> segments;
+        size_t length = 0; // Number of cycles covered by the spline
+        IK::Pose end = {}; // Pose at the final knot
+
+        static Spline fit(const std::vector<std::array<double, 4>> &samples, double tolerance);
+        bool evaluate(size_t cycle, size_t &segment, std::array<double, 4> &position) const;
+        size_t memory() const;
+    };
+} // namespace Motion
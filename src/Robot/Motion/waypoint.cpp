@@ -13,11 +13,14 @@
 //!
 //! @param origin The initial input parameters for the Ruckig OTG
 //! @param waypoints The waypoints to calculate the path between
+//! @param tolerance Spline fitting tolerance in degrees
 //! @return A tuple containing the intermediate path and the result of the calculation
-std::tuple<std::deque<IK::Pose>, ruckig::Result> Motion::calculateIntermediatePath(
-    const ruckig::InputParameter<4> origin, std::vector<IK::Pose> &waypoints)
+std::tuple<Motion::Spline, ruckig::Result> Motion::calculateIntermediatePath(const ruckig::InputParameter<4> origin,
+                                                                             std::vector<IK::Pose> &waypoints,
+                                                                             double tolerance)
 {
-    std::deque<IK::Pose> path;
+    Spline path;
+    std::vector<std::array<double, 4>> samples;
     std::deque<std::array<double, 4>> max_acceleration;
     std::deque<std::array<double, 4>> max_velocity;
 
@@ -181,24 +184,29 @@ std::tuple<std::deque<IK::Pose>, ruckig::Result> Motion::calculateIntermediatePa
                 break;
             }
 
-            auto [x, y, z, r] = IK::forwardKinematics(output.new_position[0], output.new_position[1],
-                                                      output.new_position[2], output.new_position[3]);
-
-            IK::Pose pose = {
-                .x = x,
-                .y = y,
-                .z = z,
-                .r = r,
-            };
-
-            // spdlog::info("Pose: [{}, {}, {}, {}]", pose.x, pose.y, pose.z, pose.r);
-
             output.pass_to_input(input);
 
-            path.push_back(pose);
+            samples.push_back(output.new_position);
         }
     }
 
+    path = Spline::fit(samples, tolerance);
+    if (!samples.empty())
+    {
+        auto &last = samples.back();
+        auto [x, y, z, r] = IK::forwardKinematics(last[0], last[1], last[2], last[3]);
+        path.end = {
+            .x = x,
+            .y = y,
+            .z = z,
+            .r = r,
+            .alpha = last[0],
+            .beta = last[1],
+            .theta = last[2],
+            .phi = last[3],
+        };
+    }
+
     return {path, ruckig::Result::Finished};
 }
 
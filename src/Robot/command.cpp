@@ -17,6 +17,13 @@ void Robot::FSM::receiveCommand(json payload)
         {"hotStart", Command::HotStart},
         {"moveLinear", Command::MoveLinear},
         {"moveCircular", Command::MoveCircular},
+        {"runProgram", Command::RunProgram},
+        {"jogVelocity", Command::JogVelocity},
+        {"probeMove", Command::ProbeMove},
+        {"setMode", Command::SetMode},
+        {"autotune", Command::Autotune},
+        {"identify", Command::Identify},
+        {"payload", Command::Payload},
     };
 
     auto cmd = commandMap.find(command);
@@ -29,6 +36,13 @@ void Robot::FSM::receiveCommand(json payload)
     switch (cmd->second)
     {
     case Command::Stop:
+        // Brake to rest with the drives enabled if moving, a second stop disables the drives
+        if (next == FSM::State::Tracking && status.otg.result == ruckig::Result::Working)
+        {
+            stopReason = "Stop requested";
+            stopRequest = true;
+            break;
+        }
         run = false;
         jog = false;
         break;
@@ -41,27 +55,175 @@ void Robot::FSM::receiveCommand(json payload)
     case Command::Goto:
         if (estop && !jog)
         {
-            target = payload["pose"].template get<IK::Pose>();
+            if (payload.value("frame", "base") == "conveyor")
+            {
+                if (!conveyor.valid)
+                {
+                    eventLog.Warning("Conveyor frame target rejected, no belt signal");
+                    break;
+                }
+                // Targets are relative to the belt position they were captured at, or the current one
+                conveyorReference = payload.value("reference", conveyor.position);
+                if (!conveyorTracking)
+                {
+                    conveyorSync = 0;
+                }
+                conveyorTracking = true;
+            }
+            else
+            {
+                conveyorTracking = false;
+            }
+
+            auto pose = payload["pose"].template get<IK::Pose>();
+            if (payload.contains("timestamp") && !conveyorTracking)
+            {
+                // Streamed targets are timestamped at the source and may carry their velocity
+                std::array<double, 4> velocity;
+                auto hasVelocity = payload.contains("velocity");
+                if (hasVelocity)
+                {
+                    auto v = payload["velocity"];
+                    velocity = {v.value("x", 0.0), v.value("y", 0.0), v.value("z", 0.0), v.value("r", 0.0)};
+                }
+                if (!streaming)
+                {
+                    stream.reset();
+                }
+                stream.receive(pose, payload["timestamp"].template get<int64_t>(), streamClock(),
+                               hasVelocity ? &velocity : nullptr);
+                streaming = true;
+            }
+            else
+            {
+                streaming = false;
+            }
+            target = pose;
         }
         break;
     case Command::MoveLinear:
         if (estop && !jog)
         {
             run = true;
+            conveyorTracking = false;
+            streaming = false;
             auto end = payload["pose"].template get<IK::Pose>();
             auto duration = payload["duration"].template get<double>();
             auto steps = duration * CYCLETIME / 1000;
 
-            // Get the last waypoint or the target position as the origin
-            auto start = waypoints.empty() ? target : waypoints.back();
-            auto [path, result] = Motion::linearInterpolation(start, end, steps);
+            std::vector<OutputTrigger> outputs;
+            if (payload.contains("outputs") && !parseOutputs(payload["outputs"], outputs))
+            {
+                eventLog.Warning("MoveLinear rejected, invalid output triggers");
+                return;
+            }
+
+            // Get the end of the last queued path or the target position as the origin
+            auto start = paths.empty() ? target : paths.back().end;
+            if (start.space == IK::Space::Joint)
+            {
+                auto [x, y, z, r] = IK::forwardKinematics(start.alpha, start.beta, start.theta, start.phi,
+                                                          start.toolOffset);
+                start.x = x;
+                start.y = y;
+                start.z = z;
+                start.r = r;
+            }
+            auto [path, result] = Motion::linearInterpolation(start, end, steps, pathTolerance);
             if (result != IK::Result::Success)
             {
                 KinematicAlarm = true;
                 eventLog.Kinematic(fmt::format("MoveLinear failed: {}", IK::resultToString(result)));
                 return;
             }
-            waypoints.insert(waypoints.end(), path.begin(), path.end());
+            eventLog.Debug(fmt::format("MoveLinear path of {} cycles fitted to {} segments ({} bytes)", path.length,
+                                       path.segments.size(), path.memory()));
+            pathOutputs.push_back(std::move(outputs));
+            paths.push_back(std::move(path));
+        }
+        break;
+    case Command::RunProgram:
+        if (estop && !jog)
+        {
+            if (needsHoming)
+            {
+                eventLog.Warning("Programs can not run until the robot is homed");
+                break;
+            }
+            auto id = payload["id"].template get<std::string>();
+            if (queueProgram(id, payload.value("parameters", json::object())))
+            {
+                run = true;
+            }
+        }
+        break;
+    case Command::ProbeMove:
+        if (estop && !jog)
+        {
+            if (program != nullptr || !paths.empty())
+            {
+                eventLog.Warning("Probe move rejected, the robot is following a path");
+                break;
+            }
+            // The target is released once the drives have armed their probes
+            probeTarget = payload["pose"].template get<IK::Pose>();
+            probe = Probe::Arming;
+            conveyorTracking = false;
+            streaming = false;
+            run = true;
+        }
+        break;
+    case Command::SetMode: {
+        static std::unordered_map<std::string, CANOpen::control::mode> const ModeTable = {
+            {"position", CANOpen::control::mode::POSITION_CYCLIC},
+            {"velocity", CANOpen::control::mode::VELOCITY_CYCLIC},
+            {"torque", CANOpen::control::mode::TORQUE_CYCLIC}};
+
+        // Axes switch over bumplessly in the next tracking cycle
+        auto modes = payload["modes"].template get<std::vector<std::string>>();
+        for (size_t i = 0; i < std::min(modes.size(), cyclicModes.size()); i++)
+        {
+            auto mode = ModeTable.find(modes[i]);
+            if (mode == ModeTable.end())
+            {
+                eventLog.Warning(fmt::format("Unknown mode for J{}: {}", i + 1, modes[i]));
+                continue;
+            }
+            cyclicModes[i] = mode->second;
+        }
+    }
+    break;
+    case Command::Payload:
+        // Without a mass the payload was just gripped and is estimated from the following moves
+        pendingPayload = payload.contains("mass") ? std::max(payload["mass"].template get<double>(), 0.0) : -1;
+        payloadPending = true;
+        break;
+    case Command::Autotune:
+        if (estop && !jog && !run)
+        {
+            if (needsHoming)
+            {
+                eventLog.Warning("Autotune can not run until the robot is homed");
+                break;
+            }
+            if (queueTuning(payload.template get<TuneSettings>()))
+            {
+                run = true;
+            }
+        }
+        break;
+    case Command::Identify:
+        if (estop && !jog && !run)
+        {
+            if (needsHoming)
+            {
+                eventLog.Warning("Identification can not run until the robot is homed");
+                break;
+            }
+            if (queueIdentification(payload.template get<Dynamics::ExcitationSettings>()))
+            {
+                run = true;
+            }
         }
         break;
     case Command::Jog:
@@ -69,6 +231,7 @@ void Robot::FSM::receiveCommand(json payload)
         {
             run = true;
             jog = true;
+            jogVelocity = false;
             auto jog = payload["jog"].template get<IK::Pose>();
             // Jogging is relative to the current position of the actual joints
             target.alpha = J1.getPosition() + jog.alpha;
@@ -77,6 +240,31 @@ void Robot::FSM::receiveCommand(json payload)
             target.phi = J4.getPosition() + jog.phi;
         }
         break;
+    case Command::JogVelocity:
+        if (estop)
+        {
+            // Each message rearms the deadman, the arm brakes to rest if the stream stops
+            auto frame = payload.value("frame", "joint");
+            auto velocity = payload["velocity"];
+            if (frame == "cartesian")
+            {
+                publishJog(IK::Space::Cartesian, {velocity.value("x", 0.0), velocity.value("y", 0.0),
+                                                  velocity.value("z", 0.0), velocity.value("r", 0.0)});
+            }
+            else
+            {
+                publishJog(IK::Space::Joint, {velocity.value("alpha", 0.0), velocity.value("beta", 0.0),
+                                              velocity.value("theta", 0.0), velocity.value("phi", 0.0)});
+            }
+            auto timeout = std::chrono::duration<double>(payload.value("timeout", 0.2));
+            jogDeadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch() + timeout)
+                              .count();
+            jogVelocity = true;
+            run = true;
+            jog = true;
+        }
+        break;
     case Command::Waypoints:
         if (estop)
         {
@@ -96,13 +284,16 @@ void Robot::FSM::receiveCommand(json payload)
                 waypoint.theta = t;
                 waypoint.phi = p;
             }
-            auto [path, result] = Motion::calculateIntermediatePath(input, wpt);
+            auto [path, result] = Motion::calculateIntermediatePath(input, wpt, pathTolerance);
             if (result != ruckig::Result::Finished)
             {
                 KinematicAlarm = true;
                 return;
             }
-            waypoints.insert(waypoints.end(), path.begin(), path.end());
+            eventLog.Debug(fmt::format("Waypoint path of {} cycles fitted to {} segments ({} bytes)", path.length,
+                                       path.segments.size(), path.memory()));
+            pathOutputs.push_back({});
+            paths.push_back(std::move(path));
         }
         break;
     case Command::Reset:
@@ -0,0 +1,198 @@
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "conveyor.hpp"
+#include "fsm.hpp"
+
+void Robot::to_json(json &j, const ConveyorSettings &s)
+{
+    auto source = s.source == ConveyorSettings::Source::Encoder  ? "encoder"
+                  : s.source == ConveyorSettings::Source::Stream ? "stream"
+                                                                 : "none";
+    j = json{{"source", source},
+             {"slave", s.slave},
+             {"offset", s.offset},
+             {"scale", s.scale},
+             {"direction", s.direction},
+             {"syncTime", s.syncTime},
+             {"filter", s.filter},
+             {"timeout", s.timeout}};
+}
+
+void Robot::from_json(const json &j, ConveyorSettings &s)
+{
+    static std::unordered_map<std::string, ConveyorSettings::Source> const SourceTable = {
+        {"none", ConveyorSettings::Source::None},
+        {"stream", ConveyorSettings::Source::Stream},
+        {"encoder", ConveyorSettings::Source::Encoder}};
+
+    auto name = j.value("source", "none");
+    auto source = SourceTable.find(name);
+    if (source == SourceTable.end())
+    {
+        throw std::invalid_argument(fmt::format("Unknown conveyor source {}", name));
+    }
+    s.source = source->second;
+    s.slave = j.value("slave", 0);
+    s.offset = j.value("offset", size_t(0));
+    s.scale = j.value("scale", 1.0);
+    s.direction = j.value("direction", std::array<double, 2>{1, 0});
+    s.syncTime = j.value("syncTime", 0.5);
+    s.filter = j.value("filter", 0.01);
+    s.timeout = j.value("timeout", 0.1);
+
+    auto length = std::hypot(s.direction[0], s.direction[1]);
+    if (length > 0)
+    {
+        s.direction[0] /= length;
+        s.direction[1] /= length;
+    }
+}
+
+//! @brief Apply new settings and restart position counting
+//!
+//! Called from the control thread. A streamed sample received before the change is still picked
+//! up, it is dropped by the timeout check once it is stale.
+void Robot::Conveyor::configure(const ConveyorSettings &value)
+{
+    settings = value;
+    counting = false;
+    count = 0;
+    position = 0;
+    velocity = 0;
+    valid = false;
+}
+
+//! @brief Update the belt position for this cycle
+//!
+//! @param dt Cycle time in seconds
+void Robot::Conveyor::update(double dt)
+{
+    if (settings.source == ConveyorSettings::Source::Encoder)
+    {
+        auto &slave = ec_slave[settings.slave];
+        if (slave.inputs == nullptr || settings.offset + sizeof(uint32_t) > slave.Ibytes || slave.islost)
+        {
+            valid = false;
+            counting = false;
+            return;
+        }
+
+        uint32_t raw;
+        std::memcpy(&raw, slave.inputs + settings.offset, sizeof(raw));
+        if (!counting)
+        {
+            lastCount = raw;
+            counting = true;
+        }
+        // Unsigned difference handles counter wrap around
+        count += int32_t(raw - lastCount);
+        lastCount = raw;
+
+        auto next = count * settings.scale;
+        auto measured = (next - position) / dt;
+        velocity += (measured - velocity) * dt / (settings.filter + dt);
+        position = next;
+        valid = true;
+    }
+    else if (settings.source == ConveyorSettings::Source::Stream)
+    {
+        // Never wait on the command thread, an older sample is extrapolated further instead
+        if (sampleMutex.try_lock())
+        {
+            if (sampled)
+            {
+                sample = pending;
+                valid = true;
+            }
+            sampleMutex.unlock();
+        }
+        if (!valid)
+        {
+            return;
+        }
+
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+        auto age = (now - sample.timestamp) / double(TS::NSEC_PER_SECOND);
+        if (std::abs(age) > settings.timeout)
+        {
+            valid = false;
+            return;
+        }
+        position = sample.position + sample.velocity * age;
+        velocity = sample.velocity;
+    }
+    else
+    {
+        valid = false;
+    }
+}
+
+//! @brief Receive a streamed belt sample
+//!
+//! @param samplePosition Belt position in mm
+//! @param sampleVelocity Belt velocity in mm/s
+//! @param timestamp Time the sample was taken in ns since the epoch
+void Robot::Conveyor::receive(double samplePosition, double sampleVelocity, int64_t timestamp)
+{
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    pending = {.position = samplePosition, .velocity = sampleVelocity, .timestamp = timestamp};
+    sampled = true;
+}
+
+//! @brief Update conveyor settings
+//!
+//! The settings are handed to the control thread, which applies them once it is not tracking the
+//! belt.
+//!
+//! @return False if the settings were rejected
+bool Robot::FSM::updateConveyor(ConveyorSettings settings)
+{
+    if (conveyorPending)
+    {
+        spdlog::warn("Not updating conveyor because the previous settings are still pending");
+        return false;
+    }
+    if (settings.source == ConveyorSettings::Source::Encoder && (settings.slave < 1 || settings.slave > ec_slavecount))
+    {
+        eventLog.Warning(fmt::format("Conveyor encoder slave {} rejected, {} slaves on the bus", settings.slave,
+                                     ec_slavecount));
+        return false;
+    }
+
+    pendingConveyor = settings;
+    conveyorPending = true;
+    return true;
+}
+
+//! @brief Target pose moved along with the belt
+//!
+//! Conveyor frame targets are relative to the belt position given as their reference, the belt
+//! travel since then is added along the belt direction.
+IK::Pose Robot::FSM::conveyorPose() const
+{
+    auto pose = target;
+    auto travel = conveyor.position - conveyorReference;
+    pose.x += conveyor.settings.direction[0] * travel;
+    pose.y += conveyor.settings.direction[1] * travel;
+
+    return pose;
+}
+
+//! @brief Velocity of the belt frame in the robot base frame
+//!
+//! Ramped in over the sync time so the arm matches belt speed gradually as it closes in, the
+//! smoothstep keeps the ramp free of acceleration steps at either end.
+//!
+//! @return Cartesian target velocity in mm/s
+std::array<double, 4> Robot::FSM::conveyorVelocity()
+{
+    const auto dt = CYCLETIME / double(TS::NSEC_PER_SECOND);
+    conveyorSync = std::min(conveyorSync + dt / std::max(conveyor.settings.syncTime, dt), 1.0);
+
+    auto speed = conveyor.velocity * conveyorSync * conveyorSync * (3 - 2 * conveyorSync);
+    return {conveyor.settings.direction[0] * speed, conveyor.settings.direction[1] * speed, 0.0, 0.0};
+}
@@ -0,0 +1,70 @@
+#ifndef ROBOT_CONVEYOR_HPP
+#define ROBOT_CONVEYOR_HPP
+
+#include <array>
+#include <mutex>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+namespace Robot
+{
+    using json = nlohmann::json;
+
+    struct ConveyorSettings
+    {
+        enum class Source
+        {
+            None,
+            Stream,  // Timestamped samples over NATS
+            Encoder, // Counter in the cyclic process image
+        };
+
+        Source source = Source::None;
+        int slave = 0;                            // Encoder EtherCAT slave
+        size_t offset = 0;                        // Byte offset of the 32 bit counter in the slave inputs
+        double scale = 1.0;                       // mm per encoder count
+        std::array<double, 2> direction = {1, 0}; // Unit vector of belt travel in the robot base frame
+        double syncTime = 0.5;                    // Velocity feedforward ramp in seconds
+        double filter = 0.01;                     // Encoder velocity filter time constant in seconds
+        double timeout = 0.1;                     // Age at which a belt sample is considered lost in seconds
+    };
+    void to_json(json &j, const ConveyorSettings &s);
+    void from_json(const json &j, ConveyorSettings &s);
+
+    //! @brief Belt position source
+    //!
+    //! The belt position either comes from an encoder counter in the cyclic process image or from
+    //! timestamped samples streamed over NATS, which are extrapolated to the current cycle.
+    class Conveyor
+    {
+      public:
+        ConveyorSettings settings;
+        double position = 0; // mm along the belt
+        double velocity = 0; // mm/s along the belt
+        bool valid = false;
+
+        void configure(const ConveyorSettings &value);
+        void update(double dt);
+        void receive(double samplePosition, double sampleVelocity, int64_t timestamp);
+
+      private:
+        struct Sample
+        {
+            double position;
+            double velocity;
+            int64_t timestamp; // ns since the epoch
+        };
+
+        std::mutex sampleMutex;
+        Sample pending = {};
+        Sample sample = {};
+        bool sampled = false;
+
+        bool counting = false;
+        uint32_t lastCount = 0;
+        int64_t count = 0;
+    };
+} // namespace Robot
+
+#endif
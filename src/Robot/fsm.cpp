@@ -11,7 +11,7 @@
 //! - Resetting: Check if the reset command has been completed, if not, keep sending the reset command
 //!              as they often take multiple cycles to complete
 //!
-//! - Halt: Disable the drives
+//! - Halt: Quick stop the drives, once the arm is at rest clear the mode of operation and disable them
 //! - Halting: Wait for the drives to enter power off state
 //!
 //! - Start: Enable the drives
@@ -25,8 +25,20 @@
 //!
 //! - Jog: Set mode of operation to position cyclic
 //! - Jogging: Begin jogging the target position with OTG
+//!
+//! - Stop: Switch the OTG to a zero velocity target
+//! - Stopping: Brake to rest with the drives enabled, then hold position and resume tracking
+//!
+//! - Tune: Save the active dynamics and start the autotune
+//! - Tuning: Search the dynamics of each joint with characteristic moves, then store them as a preset
+//!
+//! - Identify: Move to the center of the excitation
+//! - Identifying: Run and record the excitation, the monitor thread fits the model to it
 void Robot::FSM::update()
 {
+    // Resume after a short EtherCAT dropout
+    superviseLink();
+
     // Check if any drives have the emergency stop flag set
     if (Arm.getEmergencyStop() || EtherCATFault)
     {
@@ -46,6 +58,54 @@ void Robot::FSM::update()
 
     // Update the CoE state machine
     Arm.update();
+    // Streamed targets are timed on the distributed clock the drives run on
+    syncStreamClock();
+
+    // Swap in new compensation tables for all joints in the same cycle, only at rest so the
+    // correction can't step under a moving joint
+    if (compensationPending && next == State::Idle)
+    {
+        for (size_t i = 0; i < Arm.drives.size(); i++)
+        {
+            Arm.drives[i]->compensation.swap(pendingCompensation[i]);
+        }
+        compensationPending = false;
+    }
+
+    // Conveyor settings wait until the belt is no longer tracked
+    if (conveyorPending && !conveyorTracking)
+    {
+        conveyor.configure(pendingConveyor);
+        conveyorPending = false;
+    }
+
+    // Payload grip or release from the command thread
+    if (payloadPending)
+    {
+        if (pendingPayload < 0)
+        {
+            gripPayload();
+        }
+        else
+        {
+            setPayload(pendingPayload);
+        }
+        payloadPending = false;
+    }
+
+    // Thermal settings from the settings thread
+    if (thermalPending)
+    {
+        thermal.settings = pendingThermal;
+        thermalPending = false;
+    }
+
+    // Heat the motor windings
+    thermal.update({J1.getTorque(), J2.getTorque(), J3.getTorque(), J4.getTorque()},
+                   CYCLETIME / double(TS::NSEC_PER_SECOND));
+
+    // Update the belt position
+    conveyor.update(CYCLETIME / double(TS::NSEC_PER_SECOND));
 
     // Update counters
     runtimeDuration += CYCLETIME / double(TS::NSEC_PER_SECOND);
@@ -85,6 +145,7 @@ void Robot::FSM::update()
         }
 
         Arm.faultReset();
+        faultReaction = false;
         next = State::Resetting;
 
         break;
@@ -109,15 +170,39 @@ void Robot::FSM::update()
             }
             next = State::Idle;
         }
-        else
+        else if (!Arm.mailboxBusy())
         {
+            // Only queue another reset once the last one went through, a dropped reset keeps the
+            // previous ticket and is queued again right away
             Arm.faultReset();
         }
     }
     break;
     case State::Halt:
+        // Brake the arm on the quick stop ramp before the mode is dropped
+        if (!quickStopping)
+        {
+            Arm.quickStop();
+            quickStopping = true;
+            haltCycles = 0;
+        }
+        if (!Arm.stopped() && ++haltCycles * CYCLETIME / double(TS::NSEC_PER_SECOND) < QuickStopTimeout)
+        {
+            break;
+        }
+        if (faultReacting)
+        {
+            auto latency = std::chrono::steady_clock::now().time_since_epoch() - faultDetected;
+            eventLog.Info(fmt::format("Arm {} {:.1f} ms after the fault on J{}",
+                                      Arm.stopped() ? "stopped" : "quick stop timed out",
+                                      std::chrono::duration<double, std::milli>(latency).count(), faultJoint));
+            faultReacting = false;
+        }
+        quickStopping = false;
+
         Arm.setModeOfOperation(CANOpen::control::mode::NO_MODE);
         Arm.setCommand(CANOpenCommand::DISABLE);
+        restoreBoost();
 
         inSync = false;
         jog = false;
@@ -129,7 +214,31 @@ void Robot::FSM::update()
         {
             eventLog.Info("Stopped normally");
         }
-        waypoints.clear();
+        paths.clear();
+        pathOutputs.clear();
+        moveOutputs = nullptr;
+        pathCycle = 0;
+        pathSegment = 0;
+        if (program != nullptr && holdProgram)
+        {
+            // Restart the interrupted instruction once the EtherCAT link is back
+            eventLog.Warning(fmt::format("Program {} held at instruction {}", program->id, programCounter));
+            instructionStarted = false;
+            instructionCycle = 0;
+        }
+        else if (program != nullptr)
+        {
+            eventLog.Warning(fmt::format("Program {} interrupted", program->id));
+            retireProgram();
+            status.program.running = false;
+        }
+        if (programPending)
+        {
+            eventLog.Warning(
+                fmt::format("Program {} discarded, the arm stopped before it started", pendingProgram->id));
+            programPending = false;
+        }
+        disarmProbe();
         next = State::Idle;
 
         break;
@@ -151,6 +260,16 @@ void Robot::FSM::update()
                 eventLog.Debug("Entered ON state, enter homing");
                 next = State::Home;
             }
+            else if (tune)
+            {
+                eventLog.Debug("Entered ON state, enter autotune");
+                next = State::Tune;
+            }
+            else if (identify)
+            {
+                eventLog.Debug("Entered ON state, enter identification");
+                next = State::Identify;
+            }
             else
             {
                 eventLog.Debug("Entered ON state, enter tracking");
@@ -167,7 +286,17 @@ void Robot::FSM::update()
 
         next = State::Homing;
     case State::Homing: {
-        auto homingResult = homing();
+        // Homing to a stale offset would shift every taught position
+        if (Arm.mailboxFailed())
+        {
+            eventLog.Error("Homing aborted, an SDO transfer to the drives was dropped");
+            Arm.clearMailboxFailed();
+            run = false;
+            next = State::Halt;
+            break;
+        }
+        // Start once the drives show homing mode and the homing offset went over the mailbox
+        auto homingResult = Arm.modeConfirmed() && !Arm.mailboxBusy() && homing();
         if (homingResult)
         {
             eventLog.Debug("Homing complete");
@@ -182,14 +311,67 @@ void Robot::FSM::update()
         break;
     }
     case State::Track:
-        Arm.setModeOfOperation(CANOpen::control::mode::POSITION_CYCLIC);
+        // Axes move to their requested mode while tracking, once their targets are written
+        if (!awaitCyclicMode(CANOpen::control::mode::POSITION_CYCLIC))
+        {
+            break;
+        }
+        holdProgram = false;
+        collision.reset();
+        Arm.holdStatistics();
+        baseAcceleration = input.max_acceleration;
+        baseJerk = input.max_jerk;
+        boost = {1, 1, 1, 1};
+        boosted = true;
+        otg.backend = trackingBackend;
         next = State::Tracking;
         break;
     case State::Tracking: {
-        if (waypoints.size() > 0)
+        // A running program owns the target, queued paths resume once it completes
+        if (program != nullptr || programPending)
+        {
+            stepProgram();
+        }
+
+        // Follow queued paths, moving straight on to the next one when a path is exhausted
+        std::array<double, 4> joints;
+        while (program == nullptr && !paths.empty() && !paths.front().evaluate(pathCycle, pathSegment, joints))
+        {
+            // Hold the final knot in joint space so the elbow configuration can't flip
+            target = paths.front().end;
+            target.space = IK::Space::Joint;
+            finishOutputs();
+            paths.pop_front();
+            pathOutputs.pop_front();
+            pathCycle = 0;
+            pathSegment = 0;
+        }
+        if (program == nullptr && !paths.empty())
         {
-            target = waypoints.front();
-            waypoints.pop_front();
+            if (pathCycle == 0)
+            {
+                Arm.holdStatistics();
+                startOutputs(&pathOutputs.front());
+            }
+            updateOutputs(pathCycle * CYCLETIME / double(TS::NSEC_PER_SECOND),
+                          (paths.front().length - 1 - pathCycle) * CYCLETIME / double(TS::NSEC_PER_SECOND));
+            target.alpha = joints[0];
+            target.beta = joints[1];
+            target.theta = joints[2];
+            target.phi = joints[3];
+            target.space = IK::Space::Joint;
+            pathCycle++;
+        }
+        updateProbe();
+        boostDynamics();
+
+        for (size_t i = 0; i < Arm.drives.size(); i++)
+        {
+            if (Arm.drives[i]->cyclicMode != cyclicModes[i])
+            {
+                eventLog.Debug(fmt::format("J{} switching to {}", i + 1, Drive::modeToString(cyclicModes[i])));
+                Arm.drives[i]->switchCyclicMode(cyclicModes[i]);
+            }
         }
 
         auto trackingResult = tracking();
@@ -203,11 +385,97 @@ void Robot::FSM::update()
             inSync = false;
             next = State::Halt;
         }
+        else if (stopRequest || brakingLimit())
+        {
+            stopRequest = false;
+            next = State::Stop;
+        }
         powerOnDuration += CYCLETIME / TS::NSEC_PER_SECOND;
     }
     break;
+    case State::Stop:
+        configureStop();
+
+        next = State::Stopping;
+        [[fallthrough]];
+    case State::Stopping: {
+        auto stoppingResult = stopping();
+        if (!estop || stoppingResult)
+        {
+            eventLog.Warning("Controlled stop interrupted");
+            releaseStop();
+            inSync = false;
+            next = State::Halt;
+        }
+        else if (status.otg.result == ruckig::Result::Finished)
+        {
+            eventLog.Info("Controlled stop complete");
+            releaseStop();
+            next = run ? State::Tracking : State::Halt;
+        }
+        powerOnDuration += CYCLETIME / double(TS::NSEC_PER_SECOND);
+    }
+    break;
+    case State::Tune:
+        if (!awaitCyclicMode(CANOpen::control::mode::POSITION_CYCLIC))
+        {
+            break;
+        }
+        collision.reset();
+        Arm.holdStatistics();
+        otg.backend = Motion::Backend::Ruckig;
+        configureTuning();
+
+        next = State::Tuning;
+        break;
+    case State::Tuning: {
+        auto tuningResult = tuning();
+        if (!estop || !run || tuningResult)
+        {
+            if (tune)
+            {
+                finishTuning(false);
+            }
+            inSync = false;
+            next = State::Halt;
+        }
+        powerOnDuration += CYCLETIME / double(TS::NSEC_PER_SECOND);
+    }
+    break;
+    case State::Identify:
+        if (!awaitCyclicMode(CANOpen::control::mode::POSITION_CYCLIC))
+        {
+            break;
+        }
+        collision.reset();
+        Arm.holdStatistics();
+        otg.backend = Motion::Backend::Ruckig;
+        configureIdentification();
+
+        next = State::Identifying;
+        break;
+    case State::Identifying: {
+        auto identificationResult = identifying();
+        if (!estop || !run || identificationResult)
+        {
+            if (identify)
+            {
+                finishIdentification(false);
+            }
+            inSync = false;
+            next = State::Halt;
+        }
+        powerOnDuration += CYCLETIME / double(TS::NSEC_PER_SECOND);
+    }
+    break;
     case State::Jog:
-        Arm.setModeOfOperation(CANOpen::control::mode::POSITION_CYCLIC);
+        if (!awaitCyclicMode(CANOpen::control::mode::POSITION_CYCLIC))
+        {
+            break;
+        }
+        collision.reset();
+        Arm.holdStatistics();
+        otg.backend = joggingBackend;
         setJoggingDynamics();
 
         next = State::Jogging;
@@ -219,11 +487,116 @@ void Robot::FSM::update()
             eventLog.Warning("Jogging interrupted EStop: " + std::to_string(estop) + " Run: " + std::to_string(run));
             inSync = false;
             next = State::Halt;
+            jogVelocity = false;
+            input.control_interface = ControlInterface::Position;
+            input.target_velocity = {0.0, 0.0, 0.0, 0.0};
             restoreDynamics();
         }
         powerOnDuration += CYCLETIME / double(TS::NSEC_PER_SECOND);
         break;
     }
+
+    // Faults raised anywhere in this cycle stop the whole group before the next frame goes out
+    reactToFault();
+}
+
+//! @brief Quick stop every drive in the same cycle one of them faults
+//!
+//! A faulted drive drops its axis, the others would keep following their last setpoint until the
+//! halt got through the mailbox. The quick stop goes out with the next frame instead, the halt then
+//! waits for the arm to come to rest.
+void Robot::FSM::reactToFault()
+{
+    if (faultReaction)
+    {
+        return;
+    }
+
+    Drive::Motor *trigger = nullptr;
+    auto powered = false;
+    for (auto &&drive : Arm.drives)
+    {
+        if (drive->fault && (trigger == nullptr || drive->faultTimestamp < trigger->faultTimestamp))
+        {
+            trigger = drive;
+        }
+        powered = powered || drive->compareState(CANOpenState::ON);
+    }
+    if (trigger == nullptr || !powered)
+    {
+        return;
+    }
+
+    Arm.quickStop();
+    faultReaction = true;
+    faultReacting = true;
+    faultDetected = trigger->faultTimestamp;
+    faultJoint = trigger->slaveID;
+    quickStopping = true;
+    haltCycles = 0;
+    run = false;
+
+    auto latency = std::chrono::steady_clock::now().time_since_epoch() - faultDetected;
+    eventLog.Error(fmt::format("J{} {}, quick stop of all axes issued {:.0f} us after detection", faultJoint,
+                               trigger->lastFault, std::chrono::duration<double, std::micro>(latency).count()));
+}
+
+//! @brief Switch the arm to a cyclic mode and wait for the drives to confirm it
+//!
+//! The mode goes out with the process data, the entry state of a motion calls this every cycle
+//! until the mode of operation display of every drive matches so no setpoint is sent in the
+//! wrong mode. The drives hold position in the meantime. Halts if the run is cancelled or a drive
+//! doesn't switch within the timeout.
+//!
+//! @return True once every drive runs in the mode
+bool Robot::FSM::awaitCyclicMode(CANOpen::control::mode value)
+{
+    if (!modeRequested)
+    {
+        Arm.switchCyclicMode(value);
+        modeRequested = true;
+        modeCycles = 0;
+    }
+    if (Arm.modeConfirmed())
+    {
+        eventLog.Debug(fmt::format("Drives confirmed {} mode after {} cycles", Drive::modeToString(value), modeCycles));
+        modeRequested = false;
+        return true;
+    }
+
+    if (++modeCycles * CYCLETIME / double(TS::NSEC_PER_SECOND) >= ModeTimeout)
+    {
+        for (auto &&drive : Arm.drives)
+        {
+            if (!drive->modeConfirmed())
+            {
+                eventLog.Error(fmt::format("J{} did not switch to {} mode, running in {}", drive->slaveID,
+                                           Drive::modeToString(value),
+                                           Drive::modeToString(drive->getModeOfOperation())));
+            }
+        }
+        run = false;
+    }
+    if (!estop || !run)
+    {
+        modeRequested = false;
+        next = State::Halt;
+    }
+    return false;
+}
+
+//! @brief Step the OTG and record its result and calculation time
+ruckig::Result Robot::FSM::updateOTG()
+{
+    status.otg.result = otg.update(input, output);
+    if (output.new_calculation)
+    {
+        status.otg.calculationDuration = output.calculation_duration;
+        status.otg.maxCalculationDuration = std::max(status.otg.maxCalculationDuration, output.calculation_duration);
+    }
+    status.otg.backend = otg.getActiveBackend();
+
+    return status.otg.result;
 }
 
 std::string Robot::FSM::to_string() const
@@ -256,6 +629,18 @@ std::string Robot::FSM::to_string() const
         return "Jog";
     case State::Jogging:
         return "Jogging";
+    case State::Stop:
+        return "Stop";
+    case State::Stopping:
+        return "Stopping";
+    case State::Tune:
+        return "Tune";
+    case State::Tuning:
+        return "Tuning";
+    case State::Identify:
+        return "Identify";
+    case State::Identifying:
+        return "Identifying";
     default:
         return "[Unknown State]";
     }
@@ -265,6 +650,7 @@ std::string Robot::FSM::to_string() const
 std::string Robot::FSM::dump() const
 {
     std::vector<std::string> lines;
+    lines.push_back(fmt::format("Target space: {}", target.space == IK::Space::Joint ? "joint" : "cartesian"));
     auto [fx, fy, fz, fr, preResult] = IK::preprocessing(target.x, target.y, target.z, target.r);
     auto [alpha, beta, theta, phi, ikResult] = IK::inverseKinematics(fx, fy, fz, fr);
 
@@ -1,7 +1,9 @@
 #ifndef ROBOT_FSM_HPP
 #define ROBOT_FSM_HPP
 
+#include <atomic>
 #include <deque>
+#include <mutex>
 
 #include "ethercat.h"
 #include "nats.h"
@@ -10,11 +12,22 @@
 
 #include "../common.hpp"
 #include "Drive/group.hpp"
+#include "Dynamics/collision.hpp"
+#include "Dynamics/identification.hpp"
+#include "Dynamics/model.hpp"
+#include "Dynamics/payload.hpp"
+#include "Dynamics/thermal.hpp"
 #include "IK/scara.hpp"
 #include "Motion/motion.hpp"
+#include "Motion/profile.hpp"
+#include "conveyor.hpp"
 #include "event.hpp"
+#include "outputs.hpp"
+#include "program.hpp"
 #include "settings.hpp"
+#include "stream.hpp"
 #include "status.hpp"
+#include "tuning.hpp"
 
 namespace Robot
 {
@@ -34,6 +47,13 @@ namespace Robot
         HotStart,
         MoveLinear,
         MoveCircular,
+        RunProgram,
+        JogVelocity,
+        ProbeMove,
+        SetMode,
+        Autotune,
+        Identify,
+        Payload,
     };
 
     class FSM
@@ -62,6 +82,12 @@ namespace Robot
             Jogging,
             Track,
             Tracking,
+            Stop,
+            Stopping,
+            Tune,
+            Tuning,
+            Identify,
+            Identifying,
         } next = State::Idle;
 
         EventLog eventLog = {};
@@ -73,11 +99,21 @@ namespace Robot
         Drive::Motor J3;
         Drive::Motor J4;
         Drive::Group Arm;
+        Dynamics::Model model;
+        Dynamics::CollisionDetector collision;
+        Dynamics::ThermalModel thermal;
+        // Thermal settings handed over from the settings thread
+        std::atomic<bool> thermalPending = false;
+        Dynamics::ThermalSettings pendingThermal;
+        Dynamics::PayloadEstimator payloadEstimator;
 
-        // Create instances: the Ruckig OTG as well as input and output parameters
-        Ruckig<4> otg{CYCLETIME / double(TS::NSEC_PER_SECOND)}; // control cycle
+        // Create instances: the OTG as well as input and output parameters
+        Motion::Generator<4> otg{CYCLETIME / double(TS::NSEC_PER_SECOND)}; // control cycle
         InputParameter<4> input;
         OutputParameter<4> output;
+        // Targets at rest take the profile, anything else falls through to Ruckig
+        Motion::Backend trackingBackend = Motion::Backend::Profile;
+        Motion::Backend joggingBackend = Motion::Backend::Profile;
 
         // Settings
         std::array<OTGSettings, 4> previousDynamics;
@@ -120,11 +156,173 @@ namespace Robot
             .thetaVelocity = 0,
             .phiVelocity = 0,
         };
-        // Waypoints
-        std::deque<IK::Pose> waypoints;
+        // Paths
+        std::deque<Motion::Spline> paths;
+        size_t pathCycle = 0;
+        size_t pathSegment = 0;
+        double pathTolerance = 1e-3; // Spline fitting tolerance in degrees
+        std::deque<std::vector<OutputTrigger>> pathOutputs;
+
+        // Output triggers of the move in progress
+        const std::vector<OutputTrigger> *moveOutputs = nullptr;
+        uint32_t outputsFired = 0;
+
+        // Velocity jog
+        bool jogVelocity = false;
+        IK::Space jogFrame = IK::Space::Joint;
+        std::array<double, 4> jogCommand = {0.0, 0.0, 0.0, 0.0};
+        std::atomic<int64_t> jogDeadline = 0; // Deadman expiry in ns of the steady clock
+        // Command published by the command thread, guarded by a sequence that is odd while it is written
+        std::atomic<uint32_t> jogSequence = 0;
+        std::atomic<IK::Space> pendingJogFrame = IK::Space::Joint;
+        std::array<std::atomic<double>, 4> pendingJogCommand = {};
+        bool jogLimited = false;
+
+        // Dynamics scaled up by the thermal headroom while tracking
+        static constexpr double BoostHysteresis = 0.02; // Scale change before the OTG limits are updated
+        std::array<double, 4> baseAcceleration = {};
+        std::array<double, 4> baseJerk = {};
+        std::array<double, 4> boost = {1, 1, 1, 1};
+        bool boosted = false;
+        std::array<double, 4> payloadScale = {1, 1, 1, 1}; // Dynamics scale for the payload held
+        // Handoff from the command thread, a negative mass starts estimating
+        std::atomic<bool> payloadPending = false;
+        double pendingPayload = -1;
+
+        // Autotune, bisection per joint over velocity, acceleration and jerk
+        static constexpr double TuneReach = 0.95; // Share of the tested limit a trial has to reach
+        enum class TunePhase
+        {
+            Center, // Moving to the start of the characteristic moves
+            Out,
+            Back,
+        } tunePhase = TunePhase::Center;
+        bool tune = false;
+        TuneSettings tuneSettings;
+        std::array<OTGSettings, 4> tuneBase;
+        std::array<OTGSettings, 4> tuneResult;
+        size_t tuneJoint = 0;
+        size_t tuneLimit = 0; // Velocity, acceleration or jerk
+        size_t tuneIteration = 0;
+        double tuneLow = 0;  // Highest value known to be within budget
+        double tuneHigh = 0; // Lowest value known to be over budget
+        double tuneValue = 0;
+        bool tuneFailed = false;
+        double tuneFollowingError = 0;
+        double tuneTorque = 0;
+        double tunePeak = 0;         // Highest velocity, acceleration or jerk of the joint in the trial
+        double tuneAcceleration = 0; // Acceleration of the joint in the last cycle
+        // Handoff to the monitor thread which stores the preset
+        std::atomic<bool> tunePending = false;
+        Preset tunedPreset;
+
+        // Dynamics identification, the excitation is recorded here and fitted by the monitor thread
+        static constexpr size_t MaxIdentificationSamples = 300000; // 5 minutes at 1 kHz
+        bool identify = false;
+        bool excited = false; // At the center, running the excitation
+        Dynamics::Excitation excitation;
+        double excitationTime = 0;
+        std::vector<Dynamics::Sample> recording; // Reserved when queued, the control thread only appends
+        std::atomic<bool> identificationPending = false;
+
+        // Cyclic synchronous mode requested per axis, applied while tracking
+        std::array<CANOpen::control::mode, 4> cyclicModes = {
+            CANOpen::control::mode::POSITION_CYCLIC, CANOpen::control::mode::POSITION_CYCLIC,
+            CANOpen::control::mode::POSITION_CYCLIC, CANOpen::control::mode::POSITION_CYCLIC};
+
+        // Touch probe
+        enum class Probe
+        {
+            Idle,
+            Arming,    // Clearing the previous latch
+            Enabling,  // Waiting for the drives to enable the probe
+            Armed,     // Moving to the target until the probe latches
+            Latching,  // Latched on some drives, waiting on the rest
+        } probe = Probe::Idle;
+        static constexpr size_t ProbeLatchWindow = 10; // Cycles the drives may disagree on the edge
+        IK::Pose probeTarget = {};
+        size_t probeCycles = 0;
+
+        // Conveyor tracking
+        Conveyor conveyor;
+        bool conveyorTracking = false;
+        double conveyorReference = 0; // Belt position the target is relative to
+        double conveyorSync = 0;      // Feedforward ramp progress
+        // Handoff from the settings thread
+        std::atomic<bool> conveyorPending = false;
+        ConveyorSettings pendingConveyor;
+
+        // Streamed targets
+        TargetStream stream;
+        bool streaming = false;
+        static constexpr int64_t DCEpoch = 946684800 * int64_t(TS::NSEC_PER_SECOND); // 2000-01-01 in Unix time, ns
+        std::atomic<int64_t> streamOffset = 0; // ns from the wall clock to the distributed clock
+
+        // Programs
+        static constexpr double ProgramStartTolerance = 0.01; // Degrees
+        std::mutex programMutex;
+        std::unordered_map<std::string, std::shared_ptr<const Program>> programs;
+        std::shared_ptr<const Program> program;
+        std::vector<double> programParameters;
+        std::vector<int64_t> programCounters;
+        size_t programCounter = 0;
+        size_t programSegment = 0;
+        size_t instructionCycle = 0;
+        bool instructionStarted = false;
+        bool programPreplanned = false; // The next move was planned while the current one runs
+        // Ids of the running and the queued program by queue sequence, so the status never copies the
+        // string on the control thread. Set by queueProgram and read by broadcastStatus under the mutex.
+        std::array<std::string, 2> programIds;
+        size_t programQueued = 0;
+        std::atomic<size_t> programStarted = 0; // Queue sequence of the program last started
+        // Handoff from the command thread
+        std::atomic<bool> programPending = false;
+        std::shared_ptr<const Program> pendingProgram;
+        size_t pendingSequence = 0;
+        std::vector<double> pendingParameters;
+        std::vector<int64_t> pendingCounters;
+        // Programs the control thread stopped running, released by the command thread so the last
+        // reference is never dropped in the cycle. A program may stop after the next one was queued
+        // and before it starts, which then stops as well, so two are retired between queueProgram calls.
+        static constexpr size_t RetiredPrograms = 2;
+        std::array<std::shared_ptr<const Program>, RetiredPrograms> retiredPrograms;
+        std::array<std::atomic<bool>, RetiredPrograms> programRetired = {};
+
+        // Joint compensation tables handed to the drives, the tables they replace are kept here until
+        // the next load so they are never freed in the control thread
+        std::atomic<bool> compensationPending = false;
+        std::array<std::shared_ptr<const Drive::Compensation>, 4> pendingCompensation;
 
         Status status;
 
+        // Controlled stop
+        bool stopRequest = false;
+        std::string stopReason;
+        Synchronization previousSynchronization = Synchronization::TimeIfNecessary;
+
+        // Fault reaction
+        static constexpr double QuickStopTimeout = 0.5; // s the halt waits for the arm to come to rest
+        bool faultReaction = false;                     // Group quick stopped for the pending fault
+        bool faultReacting = false;                     // Waiting to log the time to standstill
+        bool quickStopping = false;
+        size_t haltCycles = 0;
+        std::chrono::nanoseconds faultDetected = {};
+        int faultJoint = 0;
+
+        // EtherCAT hot reconnect
+        static constexpr double ReconnectTimeout = 2.0;    // s of dropout after which the operator has to start
+        static constexpr double ReconnectTolerance = 0.05; // Degrees a joint may have moved during the dropout
+        bool linkLost = false;
+        bool linkResume = false;  // Tracking when the link dropped
+        bool holdProgram = false; // Keep the running program over the halt
+        std::chrono::nanoseconds linkLostTimestamp = {};
+        std::array<double, 4> linkPositions = {};
+
+        // Mode of operation switch
+        static constexpr double ModeTimeout = 0.1; // s for the drives to show a new mode
+        bool modeRequested = false;                // Cyclic mode written by the entry state
+        size_t modeCycles = 0;
+
         bool KinematicAlarm = false;
         bool EtherCATFault = false;
 
@@ -147,13 +345,70 @@ namespace Robot
         }
 
         void update();
+        void reactToFault();
+        void superviseLink();
+        bool awaitCyclicMode(CANOpen::control::mode value);
         bool tracking();
         void receiveCommand(json payload);
         void broadcastStatus(natsConnection *nc = nullptr);
+        bool queueTuning(const TuneSettings &settings);
+        void configureTuning();
+        void startTrial();
+        bool evaluateTrial();
+        bool tuning();
+        void finishTuning(bool complete);
+        bool queueIdentification(const Dynamics::ExcitationSettings &settings);
+        void configureIdentification();
+        bool identifying();
+        void finishIdentification(bool complete);
         void configureHoming();
         bool homing();
         bool jogging();
+        void jogVelocityTarget();
+        void publishJog(IK::Space frame, const std::array<double, 4> &velocity);
+        bool readJog();
+        ruckig::Result updateOTG();
+        bool brakingLimit();
+        void configureStop();
+        bool stopping();
+        void releaseStop();
+        bool updateConveyor(ConveyorSettings settings);
+        IK::Pose conveyorPose() const;
+        std::array<double, 4> conveyorVelocity();
+        void streamPose(IK::Pose &pose, std::array<double, 4> &velocity);
+        void syncStreamClock();
+        int64_t streamClock() const;
+        bool collided(const std::array<double, 4> &expected);
+        void boostDynamics();
+        void gripPayload();
+        void setPayload(double mass);
+        void estimatePayload(const std::array<double, 4> &position, const std::array<double, 4> &velocity,
+                             const std::array<double, 4> &acceleration, const std::array<double, 4> &expected);
+        void applyPayload();
+        void restoreBoost();
+        void updateProbe();
+        void disarmProbe();
+        void startOutputs(const std::vector<OutputTrigger> *outputs);
+        void updateOutputs(double elapsed, double remaining);
+        void finishOutputs();
+        void loadProgram(std::string id, json source);
+        void removeProgram(std::string id);
+        bool queueProgram(std::string id, json parameters);
+        double programValue(const Instruction &instruction) const;
+        void abortProgram(std::string reason);
+        void retireProgram();
+        void releasePrograms();
+        bool programJoints(const IK::Pose &pose, std::array<double, 4> &joints) const;
+        void preplanProgram();
+        void stepProgram();
         void updateDynamics(Robot::Preset settings);
+        void updateFeedforward(Robot::FeedforwardSettings settings);
+        void updateModel(Dynamics::Parameters parameters);
+        void updateLoop(Robot::LoopSettings settings);
+        void updateCollision(Dynamics::CollisionSettings settings);
+        void updateThermal(Dynamics::ThermalSettings settings);
+        void updatePayload(Dynamics::PayloadSettings settings);
+        bool updateCompensation(json settings);
         void setJoggingDynamics();
         void restoreDynamics();
         std::string to_string() const;
@@ -0,0 +1,202 @@
+#include "fsm.hpp"
+
+//! @brief Check an identification request and reserve its recording
+//!
+//! The excitation must stay inside the soft limits, clear of the base and within the active
+//! dynamics. The recording is allocated here so the control thread only appends to it.
+//!
+//! @return False if the request was rejected
+bool Robot::FSM::queueIdentification(const Dynamics::ExcitationSettings &settings)
+{
+    if (identificationPending)
+    {
+        eventLog.Warning("Identification rejected, the previous recording is still being fitted");
+        return false;
+    }
+
+    Dynamics::Excitation candidate;
+    candidate.settings = settings;
+    auto samples = size_t(candidate.duration() * TS::NSEC_PER_SECOND / CYCLETIME) + 1;
+    if (settings.period < 1 || settings.harmonics == 0 || settings.harmonics > 20 || settings.periods == 0 ||
+        samples > MaxIdentificationSamples)
+    {
+        eventLog.Warning("Identification rejected, invalid excitation or longer than the recording");
+        return false;
+    }
+
+    auto velocity = candidate.peakVelocity();
+    auto acceleration = candidate.peakAcceleration();
+    auto moving = false;
+    for (size_t i = 0; i < Arm.drives.size(); i++)
+    {
+        auto drive = Arm.drives[i];
+        auto amplitude = std::abs(settings.amplitude[i]);
+        if (settings.center[i] - amplitude < drive->minPosition || settings.center[i] + amplitude > drive->maxPosition)
+        {
+            eventLog.Warning(fmt::format("Identification rejected, J{} moves outside its soft limits", i + 1));
+            return false;
+        }
+        if (velocity[i] > input.max_velocity[i] || acceleration[i] > input.max_acceleration[i])
+        {
+            eventLog.Warning(fmt::format("Identification rejected, J{} needs {:.0f}°/s and {:.0f}°/s², raise the "
+                                         "period or lower the amplitude",
+                                         i + 1, velocity[i], acceleration[i]));
+            return false;
+        }
+        moving = moving || amplitude > 0;
+    }
+    if (!moving)
+    {
+        eventLog.Warning("Identification rejected, no joint to excite");
+        return false;
+    }
+
+    // Every corner of the excitation box must clear the base
+    for (size_t corner = 0; corner < 16; corner++)
+    {
+        auto extent = settings.center;
+        for (size_t i = 0; i < 4; i++)
+        {
+            extent[i] += (corner & (1 << i) ? 1 : -1) * std::abs(settings.amplitude[i]);
+        }
+        auto [a, b, t, p, result] = IK::postprocessing(extent[0], extent[1], extent[2], extent[3]);
+        if (result != IK::Result::Success)
+        {
+            eventLog.Warning("Identification rejected, the excitation comes too close to the base");
+            return false;
+        }
+    }
+
+    excitation = candidate;
+    recording.clear();
+    recording.reserve(samples);
+    identify = true;
+    return true;
+}
+
+//! @brief Move to the center of the excitation before recording
+void Robot::FSM::configureIdentification()
+{
+    excitationTime = 0;
+    excited = false;
+
+    input.control_interface = ControlInterface::Position;
+    input.target_position = excitation.settings.center;
+    input.target_velocity = {0.0, 0.0, 0.0, 0.0};
+    input.target_acceleration = {0.0, 0.0, 0.0, 0.0};
+
+    status.identification = {.active = true, .progress = 0, .samples = 0};
+    eventLog.Info("Identification started");
+}
+
+//! @brief Run the excitation and record the drives
+//!
+//! The OTG brings the arm to the center, then the excitation is fed to the drives directly with
+//! the model feedforward. Actual position, velocity and torque are recorded every cycle.
+//!
+//! @return True if the identification encountered an error and the drives must be disabled
+bool Robot::FSM::identifying()
+{
+    if (!inSync)
+    {
+        input.current_position = {
+            J1.getPosition(),
+            J2.getPosition(),
+            J3.getPosition(),
+            J4.getPosition(),
+        };
+        input.current_velocity = {
+            J1.getVelocity(),
+            J2.getVelocity(),
+            J3.getVelocity(),
+            J4.getVelocity(),
+        };
+        input.current_acceleration = {0.0, 0.0};
+        otg.reset();
+
+        eventLog.Kinematic("Resync OTG to actual position");
+        inSync = true;
+    }
+
+    auto result = ruckig::Result::Working;
+    std::array<double, 4> p, v, a;
+    if (!excited)
+    {
+        result = updateOTG();
+        p = output.new_position;
+        v = output.new_velocity;
+        a = output.new_acceleration;
+    }
+    else
+    {
+        excitationTime += CYCLETIME / double(TS::NSEC_PER_SECOND);
+        excitation.evaluate(excitationTime, p, v, a);
+
+        if (recording.size() < recording.capacity())
+        {
+            recording.push_back({
+                .position = {J1.getPosition(), J2.getPosition(), J3.getPosition(), J4.getPosition()},
+                .velocity = {J1.getVelocity(), J2.getVelocity(), J3.getVelocity(), J4.getVelocity()},
+                .torque = {J1.getTorque(), J2.getTorque(), J3.getTorque(), J4.getTorque()},
+            });
+        }
+        status.identification.progress = excitationTime / excitation.duration();
+        status.identification.samples = recording.size();
+    }
+
+    auto t = model.torque(p, v, a);
+    if (collided(t))
+    {
+        run = false;
+        return true;
+    }
+
+    if (J1.move(p[0], v[0], t[0]) || J2.move(p[1], v[1], t[1]) || J3.move(p[2], v[2], t[2]) ||
+        J4.move(p[3], v[3], t[3]))
+    {
+        for (auto &&drive : Arm.drives)
+        {
+            if (drive->fault)
+            {
+                eventLog.Error("J" + std::to_string(drive->slaveID) + " " + drive->lastFault, dump());
+            }
+        }
+        run = false;
+        return true;
+    }
+
+    if (!excited)
+    {
+        output.pass_to_input(input);
+        excited = result == ruckig::Result::Finished;
+    }
+    else if (excitationTime >= excitation.duration())
+    {
+        // The excitation ends at rest on the center, hand the OTG the same state
+        input.current_position = p;
+        input.current_velocity = {0.0, 0.0, 0.0, 0.0};
+        input.current_acceleration = {0.0, 0.0, 0.0, 0.0};
+        finishIdentification(true);
+    }
+
+    return false;
+}
+
+//! @brief Hand the recording over to the monitor thread for the fit
+//!
+//! @param complete True if the excitation ran to the end
+void Robot::FSM::finishIdentification(bool complete)
+{
+    identify = false;
+    status.identification.active = false;
+
+    if (!complete)
+    {
+        eventLog.Warning("Identification interrupted");
+        return;
+    }
+
+    identificationPending = true;
+    eventLog.Info(fmt::format("Identification recorded {} samples", recording.size()));
+    run = false;
+}
@@ -24,15 +24,32 @@ bool Robot::FSM::jogging()
         inSync = true;
     }
 
-    input.target_position[0] = target.alpha;
-    input.target_position[1] = target.beta;
-    input.target_position[2] = target.theta;
-    input.target_position[3] = target.phi;
+    if (jogVelocity)
+    {
+        jogVelocityTarget();
+    }
+    else
+    {
+        input.control_interface = ControlInterface::Position;
+        input.target_position[0] = target.alpha;
+        input.target_position[1] = target.beta;
+        input.target_position[2] = target.theta;
+        input.target_position[3] = target.phi;
+    }
 
-    status.otg.result = otg.update(input, output);
+    updateOTG();
     auto &p = output.new_position;
+    auto &v = output.new_velocity;
+    auto t = model.torque(p, v, output.new_acceleration);
+    if (collided(t))
+    {
+        jog = false;
+        run = false;
+        return true;
+    }
 
-    if (J1.move(p[0]) || J2.move(p[1]) || J3.move(p[2]) || J4.move(p[3]))
+    if (J1.move(p[0], v[0], t[0]) || J2.move(p[1], v[1], t[1]) || J3.move(p[2], v[2], t[2]) ||
+        J4.move(p[3], v[3], t[3]))
     {
         for (auto &&drive : Arm.drives)
         {
@@ -50,4 +67,115 @@ bool Robot::FSM::jogging()
     output.pass_to_input(input);
 
     return false;
-}
\ No newline at end of file
+}
+//! @brief Publish a velocity jog command from the command thread
+void Robot::FSM::publishJog(IK::Space frame, const std::array<double, 4> &velocity)
+{
+    auto sequence = jogSequence.load(std::memory_order_relaxed);
+    jogSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    pendingJogFrame.store(frame, std::memory_order_relaxed);
+    for (size_t i = 0; i < 4; i++)
+    {
+        pendingJogCommand[i].store(velocity[i], std::memory_order_relaxed);
+    }
+    jogSequence.store(sequence + 2, std::memory_order_release);
+}
+
+//! @brief Take over the velocity jog command on the control thread
+//!
+//! Never waits for the command thread, a command caught while it is written is left for the next
+//! cycle.
+//!
+//! @return False if the command was being written
+bool Robot::FSM::readJog()
+{
+    auto sequence = jogSequence.load(std::memory_order_acquire);
+    if (sequence & 1)
+    {
+        return false;
+    }
+    auto frame = pendingJogFrame.load(std::memory_order_relaxed);
+    std::array<double, 4> velocity;
+    for (size_t i = 0; i < 4; i++)
+    {
+        velocity[i] = pendingJogCommand[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (jogSequence.load(std::memory_order_relaxed) != sequence)
+    {
+        return false;
+    }
+    jogFrame = frame;
+    jogCommand = velocity;
+    return true;
+}
+
+//! @brief Set the OTG velocity target for a velocity jog
+//!
+//! Joint frame velocities are used as is, cartesian velocities are mapped through the inverse
+//! Jacobian at the current position every cycle. The arm brakes to rest if the client stops
+//! refreshing the command before the deadman expires or if braking would no longer stop it inside
+//! the soft limits.
+void Robot::FSM::jogVelocityTarget()
+{
+    input.control_interface = ControlInterface::Velocity;
+    input.target_velocity = {0.0, 0.0, 0.0, 0.0};
+    input.target_acceleration = {0.0, 0.0, 0.0, 0.0};
+
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+                   .count();
+    if (now > jogDeadline)
+    {
+        return;
+    }
+
+    // A command being written keeps the one of the last cycle
+    readJog();
+
+    auto &p = input.current_position;
+    std::array<double, 4> velocity = jogCommand;
+    if (jogFrame == IK::Space::Cartesian)
+    {
+        auto [x, y, z, r] = IK::forwardKinematics(p[0], p[1], p[2], p[3], target.toolOffset);
+        auto [da, db, dt, dp, result] = IK::jointVelocity(p[0], p[1], r, velocity[0], velocity[1], velocity[2],
+                                                          velocity[3], target.toolOffset);
+        if (result != IK::Result::Success)
+        {
+            if (!jogLimited)
+            {
+                eventLog.Kinematic("Cartesian jog stopped at singularity", dump());
+                jogLimited = true;
+            }
+            return;
+        }
+        velocity = {da, db, dt, dp};
+    }
+
+    // Scale every axis together so a cartesian jog keeps its direction
+    double scale = 1.0;
+    for (size_t i = 0; i < 4; i++)
+    {
+        if (std::abs(velocity[i]) > input.max_velocity[i])
+        {
+            scale = std::min(scale, input.max_velocity[i] / std::abs(velocity[i]));
+        }
+    }
+
+    if (brakingLimit())
+    {
+        if (!jogLimited)
+        {
+            eventLog.Kinematic(fmt::format("Jog stopped: {}", stopReason));
+            jogLimited = true;
+        }
+        return;
+    }
+    jogLimited = false;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        input.target_velocity[i] = velocity[i] * scale;
+    }
+}
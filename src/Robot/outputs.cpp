@@ -0,0 +1,121 @@
+#include <bit>
+
+#include "outputs.hpp"
+#include "fsm.hpp"
+
+void Robot::to_json(json &j, const OutputTrigger &t)
+{
+    j = json{{"joint", t.joint + 1},
+             {"output", std::countr_zero(t.mask) - 15},
+             {"state", t.state},
+             {"latency", t.latency}};
+    switch (t.when)
+    {
+    case OutputTrigger::When::Fraction:
+        j["fraction"] = t.value;
+        break;
+    case OutputTrigger::When::BeforeEnd:
+        j["beforeEnd"] = t.value;
+        break;
+    case OutputTrigger::When::Reached:
+        break;
+    }
+}
+
+void Robot::from_json(const json &j, OutputTrigger &t)
+{
+    t.joint = j.at("joint").get<size_t>() - 1;
+    auto output = j.at("output").get<size_t>();
+    // DO1-DO4 occupy bits 16-19 of 0x60FE sub 1
+    t.mask = output >= 1 && output <= 4 ? 1u << (15 + output) : 0;
+    t.state = j.value("state", true);
+    t.latency = j.value("latency", 0.0);
+
+    if (j.contains("fraction"))
+    {
+        t.when = OutputTrigger::When::Fraction;
+        t.value = j["fraction"].get<double>();
+    }
+    else if (j.contains("beforeEnd"))
+    {
+        t.when = OutputTrigger::When::BeforeEnd;
+        t.value = j["beforeEnd"].get<double>();
+    }
+    else
+    {
+        t.when = OutputTrigger::When::Reached;
+        t.value = 0;
+    }
+}
+
+bool Robot::OutputTrigger::valid() const
+{
+    return joint < 4 && mask != 0 && latency >= 0 && value >= 0 && (when != When::Fraction || value <= 1);
+}
+
+//! @brief Parse the outputs attached to a move
+//!
+//! @return False if any trigger is invalid or there are too many of them
+bool Robot::parseOutputs(const json &source, std::vector<OutputTrigger> &outputs)
+{
+    outputs = source.get<std::vector<OutputTrigger>>();
+    if (outputs.size() > MaxOutputTriggers)
+    {
+        return false;
+    }
+    return std::all_of(outputs.begin(), outputs.end(), [](const OutputTrigger &t) { return t.valid(); });
+}
+
+//! @brief Arm the output triggers of the move that is starting
+void Robot::FSM::startOutputs(const std::vector<OutputTrigger> *outputs)
+{
+    moveOutputs = outputs->empty() ? nullptr : outputs;
+    outputsFired = 0;
+}
+
+//! @brief Switch the outputs that are due for the setpoint issued this cycle
+//!
+//! @param elapsed Time from the start of the move to this setpoint in seconds
+//! @param remaining Time from this setpoint to the end of the move in seconds
+void Robot::FSM::updateOutputs(double elapsed, double remaining)
+{
+    if (moveOutputs == nullptr)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < moveOutputs->size(); i++)
+    {
+        if (outputsFired & (1u << i))
+        {
+            continue;
+        }
+
+        auto &trigger = (*moveOutputs)[i];
+        auto due = false;
+        switch (trigger.when)
+        {
+        case OutputTrigger::When::Fraction:
+            due = elapsed + trigger.latency >= trigger.value * (elapsed + remaining);
+            break;
+        case OutputTrigger::When::BeforeEnd:
+            due = remaining <= trigger.value + trigger.latency;
+            break;
+        case OutputTrigger::When::Reached:
+            due = remaining <= trigger.latency;
+            break;
+        }
+        if (due)
+        {
+            Arm.drives[trigger.joint]->setDigitalOutput(trigger.mask, trigger.state);
+            outputsFired |= 1u << i;
+        }
+    }
+}
+
+//! @brief Switch any outputs still pending when the move completes
+void Robot::FSM::finishOutputs()
+{
+    updateOutputs(0, 0);
+    moveOutputs = nullptr;
+}
@@ -0,0 +1,42 @@
+#ifndef ROBOT_OUTPUTS_HPP
+#define ROBOT_OUTPUTS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace Robot
+{
+    using json = nlohmann::json;
+
+    //! @brief Digital output switched at a point along a move
+    //!
+    //! Outputs are switched early by their latency so the device acts at the requested point.
+    struct OutputTrigger
+    {
+        enum class When
+        {
+            Fraction,  // Fraction of the move duration
+            BeforeEnd, // Seconds before the end of the move
+            Reached,   // End of the move
+        } when = When::Reached;
+
+        double value = 0;   // Fraction or seconds depending on when
+        double latency = 0; // Seconds the device takes to act
+        size_t joint = 0;   // Drive index
+        uint32_t mask = 0;  // Bits of 0x60FE sub 1
+        bool state = true;
+
+        bool valid() const;
+    };
+    void to_json(json &j, const OutputTrigger &t);
+    void from_json(const json &j, OutputTrigger &t);
+
+    //! @brief Most output triggers a single move can carry
+    const size_t MaxOutputTriggers = 32;
+
+    bool parseOutputs(const json &source, std::vector<OutputTrigger> &outputs);
+} // namespace Robot
+
+#endif
@@ -0,0 +1,78 @@
+#include "fsm.hpp"
+
+//! @brief Start estimating the payload after a grip
+//!
+//! Until the estimate converges the arm moves as if it held the reference payload the preset was
+//! tuned for.
+void Robot::FSM::gripPayload()
+{
+    payloadEstimator.reset();
+    if (!payloadEstimator.active)
+    {
+        return;
+    }
+    model.parameters.payload = payloadEstimator.settings.reference;
+    payloadScale = {1, 1, 1, 1};
+    collision.scale = {1, 1, 1, 1};
+    eventLog.Debug("Estimating payload");
+}
+
+//! @brief Hold a known payload, 0 after a release
+void Robot::FSM::setPayload(double mass)
+{
+    if (!payloadEstimator.settings.enabled)
+    {
+        return;
+    }
+    payloadEstimator.set(std::max(mass, 0.0));
+    applyPayload();
+}
+
+//! @brief Refine the payload estimate with the torque of this cycle
+//!
+//! @param expected Model torque for the commanded trajectory in %
+void Robot::FSM::estimatePayload(const std::array<double, 4> &position, const std::array<double, 4> &velocity,
+                                 const std::array<double, 4> &acceleration, const std::array<double, 4> &expected)
+{
+    if (!payloadEstimator.active)
+    {
+        return;
+    }
+
+    std::array<double, 4> measured = {J1.getTorque(), J2.getTorque(), J3.getTorque(), J4.getTorque()};
+    payloadEstimator.update(expected, measured, model.payloadTorque(position, velocity, acceleration),
+                   model.parameters.payload, CYCLETIME / double(TS::NSEC_PER_SECOND));
+    auto change = std::abs(payloadEstimator.mass - model.parameters.payload);
+    if (payloadEstimator.converged && change > payloadEstimator.settings.tolerance)
+    {
+        applyPayload();
+    }
+}
+
+//! @brief Adapt the model, dynamics and collision thresholds to the payload held
+//!
+//! The acceleration and jerk limits scale with the ratio of the joint inertia at the reference
+//! payload to the inertia with the payload held, at the current position. A light payload lowers
+//! the collision thresholds by the same ratio, a heavy one never raises them.
+void Robot::FSM::applyPayload()
+{
+    auto mass = std::max(payloadEstimator.mass, 0.0);
+    auto reference = model;
+    reference.parameters.payload = payloadEstimator.settings.reference;
+    auto held = model;
+    held.parameters.payload = mass;
+
+    auto referenceInertia = reference.inertia(input.current_position);
+    auto heldInertia = held.inertia(input.current_position);
+    for (size_t i = 0; i < 4; i++)
+    {
+        auto ratio = heldInertia[i] > 0 ? referenceInertia[i] / heldInertia[i] : 1;
+        payloadScale[i] = std::min(ratio, payloadEstimator.settings.maxScale);
+        collision.scale[i] = std::clamp(1 / ratio, payloadEstimator.settings.minThreshold, 1.0);
+    }
+    model.parameters.payload = mass;
+
+    eventLog.Info(fmt::format("Payload {:.3f} kg ± {:.3f}, dynamics scaled by {:.2f} {:.2f} {:.2f} {:.2f}", mass,
+                              payloadEstimator.deviation, payloadScale[0], payloadScale[1], payloadScale[2],
+                              payloadScale[3]));
+}
@@ -0,0 +1,116 @@
+#include "fsm.hpp"
+
+//! @brief Run the touch probe sequence for one cycle
+//!
+//! Latches are rearmed on the rising edge of the function bits so they are cleared first, the
+//! probe target is only released once every drive reports the probe enabled so an early edge can't
+//! be missed. The probe input is wired to all drives, each latches its own position in hardware.
+void Robot::FSM::updateProbe()
+{
+    using namespace CANOpen::probe;
+
+    switch (probe)
+    {
+    case Probe::Idle:
+        return;
+    case Probe::Arming:
+        for (auto &&drive : Arm.drives)
+        {
+            drive->setTouchProbe(0);
+        }
+        probeCycles = 0;
+        probe = Probe::Enabling;
+        return;
+    case Probe::Enabling:
+        for (auto &&drive : Arm.drives)
+        {
+            drive->setTouchProbe(ENABLE_PROBE_1 | LATCH_RISING_EDGE);
+        }
+        if (std::all_of(Arm.drives.begin(), Arm.drives.end(),
+                        [](Drive::Motor *drive) { return drive->getTouchProbeStatus() & PROBE_1_ENABLED; }))
+        {
+            target = probeTarget;
+            probeCycles = 0;
+            probe = Probe::Armed;
+            status.probe.armed = true;
+        }
+        else if (++probeCycles > ProbeLatchWindow)
+        {
+            eventLog.Error("Touch probe failed to enable");
+            disarmProbe();
+        }
+        return;
+    case Probe::Armed:
+    case Probe::Latching: {
+        auto latched = std::count_if(Arm.drives.begin(), Arm.drives.end(), [](Drive::Motor *drive) {
+            return drive->getTouchProbeStatus() & RISING_EDGE_STORED;
+        });
+        if (latched == 0)
+        {
+            // The OTG result lags the new target by a cycle
+            if (++probeCycles > 1 && status.otg.result == ruckig::Result::Finished)
+            {
+                eventLog.Warning("Probe move completed without a trigger");
+                status.probe.triggered = false;
+                disarmProbe();
+            }
+            return;
+        }
+
+        if (probe == Probe::Armed)
+        {
+            probeCycles = 0;
+        }
+        probe = Probe::Latching;
+        if (latched < int(Arm.drives.size()) && ++probeCycles <= ProbeLatchWindow)
+        {
+            return;
+        }
+        if (latched < int(Arm.drives.size()))
+        {
+            eventLog.Error("Touch probe latched on some drives only");
+            stopReason = "Probe failed";
+            stopRequest = true;
+            disarmProbe();
+            return;
+        }
+
+        auto alpha = J1.getTouchProbePosition();
+        auto beta = J2.getTouchProbePosition();
+        auto theta = J3.getTouchProbePosition();
+        auto phi = J4.getTouchProbePosition();
+        auto [x, y, z, r] = IK::forwardKinematics(alpha, beta, theta, phi, target.toolOffset);
+        status.probe.triggered = true;
+        status.probe.count++;
+        status.probe.pose = {
+            .x = x,
+            .y = y,
+            .z = z,
+            .r = r,
+            .alpha = alpha,
+            .beta = beta,
+            .theta = theta,
+            .phi = phi,
+            .toolOffset = target.toolOffset,
+        };
+        eventLog.Info(fmt::format("Probe triggered at {:.3f}mm {:.3f}mm {:.3f}mm {:.3f}°", x, y, z, r),
+                      status.probe.pose);
+
+        stopReason = "Probe triggered";
+        stopRequest = true;
+        disarmProbe();
+    }
+    break;
+    }
+}
+
+//! @brief Switch the touch probe off on all drives
+void Robot::FSM::disarmProbe()
+{
+    for (auto &&drive : Arm.drives)
+    {
+        drive->setTouchProbe(0);
+    }
+    probe = Probe::Idle;
+    status.probe.armed = false;
+}
@@ -0,0 +1,568 @@
+#include "program.hpp"
+#include "fsm.hpp"
+
+namespace
+{
+    using Robot::Instruction;
+    using Robot::json;
+    using Robot::Program;
+
+    //! @brief Resolve a numeric operand that may instead name a program parameter
+    void compileValue(const Program &program, const json &operand, Instruction &instruction)
+    {
+        if (operand.is_string())
+        {
+            auto name = operand.get<std::string>();
+            instruction.parameter = program.findParameter(name);
+            if (instruction.parameter < 0)
+            {
+                throw std::invalid_argument(fmt::format("Unknown parameter {}", name));
+            }
+            instruction.value = program.parameters[instruction.parameter];
+            return;
+        }
+        instruction.value = operand.get<double>();
+    }
+
+    //! @brief Parse the output triggers attached to a move step
+    void compileOutputs(const json &step, Instruction &instruction)
+    {
+        if (step.contains("outputs") && !Robot::parseOutputs(step["outputs"], instruction.outputs))
+        {
+            throw std::invalid_argument("Invalid output triggers");
+        }
+    }
+
+    //! @brief Fill in the cartesian position of a joint space pose
+    IK::Pose toCartesian(IK::Pose pose)
+    {
+        if (pose.space == IK::Space::Joint)
+        {
+            auto [x, y, z, r] = IK::forwardKinematics(pose.alpha, pose.beta, pose.theta, pose.phi, pose.toolOffset);
+            pose.x = x;
+            pose.y = y;
+            pose.z = z;
+            pose.r = r;
+        }
+        return pose;
+    }
+
+    //! @brief Compile a block of steps, loops recurse into their body
+    //!
+    //! @param last Pose at the end of the previous move in program order
+    //! @param hasLast True once a move has been compiled
+    void compileBlock(Program &program, const json &block, IK::Pose &last, bool &hasLast, double tolerance)
+    {
+        for (auto &step : block)
+        {
+            auto op = step.at("op").get<std::string>();
+            Instruction instruction = {.op = Instruction::Op::End};
+
+            if (op == "move")
+            {
+                instruction.op = Instruction::Op::Move;
+                instruction.pose = step.at("pose").get<IK::Pose>();
+                compileOutputs(step, instruction);
+                last = instruction.pose;
+                hasLast = true;
+            }
+            else if (op == "moveLinear")
+            {
+                if (!hasLast)
+                {
+                    throw std::invalid_argument("moveLinear needs a preceding move to start from");
+                }
+                auto end = step.at("pose").get<IK::Pose>();
+                auto steps = step.at("duration").get<double>() * CYCLETIME / 1000;
+
+                auto [path, result] = Motion::linearInterpolation(toCartesian(last), end, steps, tolerance);
+                if (result != IK::Result::Success)
+                {
+                    throw std::invalid_argument(fmt::format("moveLinear failed: {}", IK::resultToString(result)));
+                }
+                instruction.op = Instruction::Op::MoveLinear;
+                instruction.path = program.paths.size();
+                compileOutputs(step, instruction);
+                last = path.end;
+                last.space = IK::Space::Joint;
+                program.paths.push_back(std::move(path));
+            }
+            else if (op == "dwell")
+            {
+                instruction.op = Instruction::Op::Dwell;
+                compileValue(program, step.at("time"), instruction);
+            }
+            else if (op == "waitInput")
+            {
+                auto joint = step.at("joint").get<size_t>();
+                auto input = step.at("input").get<size_t>();
+                if (joint < 1 || joint > 4 || input < 1 || input > 4)
+                {
+                    throw std::invalid_argument(fmt::format("waitInput J{} DI{} does not exist", joint, input));
+                }
+                instruction.op = Instruction::Op::WaitInput;
+                instruction.joint = joint - 1;
+                instruction.mask = 1u << (15 + input); // DI1-DI4 occupy bits 16-19 of 0x60FD
+                instruction.state = step.value("state", true);
+                compileValue(program, step.value("timeout", json(0.0)), instruction);
+            }
+            else if (op == "payload")
+            {
+                instruction.op = Instruction::Op::Payload;
+                instruction.state = !step.contains("mass");
+                if (!instruction.state)
+                {
+                    compileValue(program, step["mass"], instruction);
+                }
+            }
+            else if (op == "loop")
+            {
+                instruction.op = Instruction::Op::Loop;
+                instruction.counter = program.loops++;
+                compileValue(program, step.at("count"), instruction);
+
+                auto start = program.instructions.size();
+                program.instructions.push_back(instruction);
+                compileBlock(program, step.at("instructions"), last, hasLast, tolerance);
+                program.instructions.push_back({
+                    .op = Instruction::Op::EndLoop,
+                    .jump = start + 1,
+                    .counter = instruction.counter,
+                });
+                program.instructions[start].jump = program.instructions.size();
+                continue;
+            }
+            else
+            {
+                throw std::invalid_argument(fmt::format("Unknown op {}", op));
+            }
+
+            program.instructions.push_back(instruction);
+        }
+    }
+} // namespace
+
+//! @brief Compile a motion program
+//!
+//! A program is a list of steps, numeric operands of dwell, waitInput, payload and loop may name an
+//! entry of the parameters object instead which can be overridden when the program is run. A payload
+//! step without a mass estimates the payload just gripped from the moves that follow:
+//! @code{.json}
+//! {
+//!     "parameters": {"cycles": 10, "settle": 0.2},
+//!     "instructions": [
+//!         {"op": "move", "pose": {"x": 0, "y": 250, "z": 100, "r": 0}},
+//!         {"op": "loop", "count": "cycles", "instructions": [
+//!             {"op": "moveLinear", "pose": {"x": 0, "y": 250, "z": 0, "r": 0}, "duration": 0.5},
+//!             {"op": "waitInput", "joint": 1, "input": 1, "state": true, "timeout": 2.0},
+//!             {"op": "payload"},
+//!             {"op": "dwell", "time": "settle"},
+//!             {"op": "moveLinear", "pose": {"x": 0, "y": 250, "z": 100, "r": 0}, "duration": 0.5}
+//!         ]}
+//!     ]
+//! }
+//! @endcode
+//!
+//! @param source Program source
+//! @param tolerance Spline fitting tolerance for linear moves in degrees
+//! @return Compiled program or an empty pointer and the reason it failed
+std::tuple<std::shared_ptr<Robot::Program>, std::string> Robot::Program::compile(const json &source,
+                                                                                  double tolerance)
+{
+    auto program = std::make_shared<Program>();
+    try
+    {
+        for (auto &[name, value] : source.value("parameters", json::object()).items())
+        {
+            program->parameterNames.push_back(name);
+            program->parameters.push_back(value.get<double>());
+        }
+
+        IK::Pose last = {};
+        bool hasLast = false;
+        compileBlock(*program, source.at("instructions"), last, hasLast, tolerance);
+        program->instructions.push_back({.op = Instruction::Op::End});
+    }
+    catch (const json::exception &e)
+    {
+        return {nullptr, e.what()};
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return {nullptr, e.what()};
+    }
+
+    return {program, ""};
+}
+
+//! @brief Find the index of a named parameter
+//!
+//! @return Parameter index or -1 if the program has no such parameter
+int Robot::Program::findParameter(const std::string &name) const
+{
+    auto it = std::find(parameterNames.begin(), parameterNames.end(), name);
+    return it == parameterNames.end() ? -1 : int(it - parameterNames.begin());
+}
+
+//! @brief Compile and store a program uploaded to the program bucket
+void Robot::FSM::loadProgram(std::string id, json source)
+{
+    auto [program, error] = Program::compile(source, pathTolerance);
+    if (program == nullptr)
+    {
+        eventLog.Error(fmt::format("Program {} failed to compile: {}", id, error));
+        return;
+    }
+    program->id = id;
+
+    size_t memory = 0;
+    for (auto &path : program->paths)
+    {
+        memory += path.memory();
+    }
+    eventLog.Info(fmt::format("Program {} loaded, {} instructions and {} paths ({} bytes)", id,
+                              program->instructions.size(), program->paths.size(), memory));
+
+    std::lock_guard<std::mutex> lock(programMutex);
+    programs[id] = std::move(program);
+}
+
+//! @brief Forget a program deleted from the program bucket
+void Robot::FSM::removeProgram(std::string id)
+{
+    std::lock_guard<std::mutex> lock(programMutex);
+    releasePrograms();
+    if (programs.erase(id) > 0)
+    {
+        eventLog.Info(fmt::format("Program {} removed", id));
+    }
+}
+
+//! @brief Queue a stored program for execution
+//!
+//! Parameter overrides are resolved here so the control thread only has to swap buffers when it
+//! picks the program up.
+//!
+//! @return False if the program does not exist or another program is still waiting to start
+bool Robot::FSM::queueProgram(std::string id, json parameters)
+{
+    if (programPending)
+    {
+        return false;
+    }
+
+    std::shared_ptr<const Program> selected;
+    {
+        std::lock_guard<std::mutex> lock(programMutex);
+        releasePrograms();
+        auto it = programs.find(id);
+        if (it == programs.end())
+        {
+            eventLog.Warning(fmt::format("Program {} does not exist", id));
+            return false;
+        }
+        selected = it->second;
+    }
+
+    pendingParameters = selected->parameters;
+    for (auto &[name, value] : parameters.items())
+    {
+        auto index = selected->findParameter(name);
+        if (index < 0)
+        {
+            eventLog.Warning(fmt::format("Program {} has no parameter {}", id, name));
+            return false;
+        }
+        pendingParameters[index] = value.get<double>();
+    }
+    pendingCounters.assign(selected->loops, 0);
+    {
+        std::lock_guard<std::mutex> lock(programMutex);
+        programIds[++programQueued % programIds.size()] = id;
+        pendingSequence = programQueued;
+    }
+    pendingProgram = std::move(selected);
+    programPending = true;
+
+    return true;
+}
+
+//! @brief Value of an instruction operand after parameter substitution
+double Robot::FSM::programValue(const Instruction &instruction) const
+{
+    return instruction.parameter < 0 ? instruction.value : programParameters[instruction.parameter];
+}
+
+//! @brief Abort the running program with a controlled stop
+void Robot::FSM::abortProgram(std::string reason)
+{
+    eventLog.Error(fmt::format("Program {} aborted at {}: {}", program->id, programCounter, reason));
+    stopReason = "Program aborted";
+    stopRequest = true;
+    moveOutputs = nullptr;
+    retireProgram();
+    status.program.running = false;
+}
+
+//! @brief Stop running the program without releasing it in the control thread
+void Robot::FSM::retireProgram()
+{
+    for (size_t i = 0; i < RetiredPrograms; i++)
+    {
+        if (!programRetired[i])
+        {
+            retiredPrograms[i] = std::move(program);
+            programRetired[i] = true;
+            return;
+        }
+    }
+    // Unreachable while every program starts through queueProgram, see RetiredPrograms
+    program.reset();
+}
+
+//! @brief Release the programs retired by the control thread
+//!
+//! Called with the program mutex held, from the command and settings threads.
+void Robot::FSM::releasePrograms()
+{
+    for (size_t i = 0; i < RetiredPrograms; i++)
+    {
+        if (programRetired[i])
+        {
+            retiredPrograms[i].reset();
+            programRetired[i] = false;
+        }
+    }
+}
+
+//! @brief Joint positions of a program move target, as tracking converts it
+//!
+//! @return False if the target can't be reached
+bool Robot::FSM::programJoints(const IK::Pose &pose, std::array<double, 4> &joints) const
+{
+    if (pose.space == IK::Space::Joint)
+    {
+        auto [alpha, beta, theta, phi, result] = IK::jointLimits(pose.alpha, pose.beta, pose.theta, pose.phi);
+        joints = {alpha, beta, theta, phi};
+        return result == IK::Result::Success;
+    }
+    auto [fx, fy, fz, fr, preResult] = IK::preprocessing(pose.x, pose.y, pose.z, pose.r);
+    auto [alpha, beta, theta, phi, ikResult] = IK::inverseKinematics(fx, fy, fz, fr, pose.toolOffset);
+    joints = {alpha, beta, theta, phi};
+    return preResult == IK::Result::Success && ikResult == IK::Result::Success;
+}
+
+//! @brief Plan the next point to point move of the program while the current one runs
+//!
+//! Follows the program flow through loops, dwells and input waits, which leave the arm at rest at
+//! the current target, so the next move starts from there. Any other instruction ends the
+//! lookahead. The OTG only takes the plan over if the move then starts as planned.
+void Robot::FSM::preplanProgram()
+{
+    auto counter = programCounter + 1;
+    // A loop passed on the way sets its counter before the end of the loop reads it
+    int64_t looped = -1, loops = 0;
+    for (size_t steps = 0; steps < program->instructions.size() && counter < program->instructions.size(); steps++)
+    {
+        auto &instruction = program->instructions[counter];
+        switch (instruction.op)
+        {
+        case Instruction::Op::Move: {
+            std::array<double, 4> joints;
+            if (!programJoints(instruction.pose, joints))
+            {
+                return;
+            }
+            auto next = input;
+            next.current_position = input.target_position;
+            next.current_velocity = {0.0, 0.0, 0.0, 0.0};
+            next.current_acceleration = {0.0, 0.0, 0.0, 0.0};
+            next.target_position = joints;
+            next.target_velocity = {0.0, 0.0, 0.0, 0.0};
+            next.target_acceleration = {0.0, 0.0, 0.0, 0.0};
+            otg.preplan(next);
+            return;
+        }
+        case Instruction::Op::Loop:
+            looped = int64_t(instruction.counter);
+            loops = int64_t(std::round(programValue(instruction)));
+            counter = loops < 1 ? instruction.jump : counter + 1;
+            break;
+        case Instruction::Op::EndLoop: {
+            auto remaining = looped == int64_t(instruction.counter) ? loops : programCounters[instruction.counter];
+            counter = remaining > 1 ? instruction.jump : counter + 1;
+            break;
+        }
+        case Instruction::Op::Dwell:
+        case Instruction::Op::WaitInput:
+            counter++;
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+//! @brief Execute the running program for one cycle
+//!
+//! Zero time instructions are executed back to back within a cycle, so the next move is issued on
+//! the same cycle the previous one completes and a program repeats with identical timing.
+void Robot::FSM::stepProgram()
+{
+    if (programPending)
+    {
+        // The queued program replaces one still running
+        if (program != nullptr)
+        {
+            retireProgram();
+        }
+        program = std::move(pendingProgram);
+        programParameters.swap(pendingParameters);
+        programCounters.swap(pendingCounters);
+        programCounter = 0;
+        instructionStarted = false;
+        instructionCycle = 0;
+        programStarted = pendingSequence;
+        programPending = false;
+
+        status.program.running = true;
+        eventLog.Info(fmt::format("Program {} started", program->id));
+    }
+
+    const auto dt = CYCLETIME / double(TS::NSEC_PER_SECOND);
+    for (size_t steps = 0; program != nullptr && steps < program->instructions.size(); steps++)
+    {
+        auto &instruction = program->instructions[programCounter];
+        auto started = instructionStarted;
+        instructionStarted = true;
+        status.program.counter = programCounter;
+
+        switch (instruction.op)
+        {
+        case Instruction::Op::Move:
+            if (!started)
+            {
+                conveyorTracking = false;
+                streaming = false;
+                target = instruction.pose;
+                Arm.holdStatistics();
+                startOutputs(&instruction.outputs);
+                programPreplanned = false;
+                return;
+            }
+            if (status.otg.kinematicResult != IK::Result::Success)
+            {
+                abortProgram(fmt::format("Move target rejected: {}", IK::resultToString(status.otg.kinematicResult)));
+                return;
+            }
+            if (status.otg.result != ruckig::Result::Finished)
+            {
+                // Plan the next move while this one runs, it then starts without planning
+                if (!programPreplanned)
+                {
+                    preplanProgram();
+                    programPreplanned = true;
+                }
+                // The trajectory is only known once planned, time it from the setpoint issued this cycle
+                auto elapsed = output.time + dt;
+                updateOutputs(elapsed, std::max(otg.getDuration(output) - elapsed, 0.0));
+                return;
+            }
+            finishOutputs();
+            break;
+        case Instruction::Op::MoveLinear: {
+            auto &path = program->paths[instruction.path];
+            std::array<double, 4> joints;
+            if (!started)
+            {
+                Arm.holdStatistics();
+                startOutputs(&instruction.outputs);
+
+                // Paths are fitted from the previous move in program order, make sure we are actually there
+                programSegment = 0;
+                path.evaluate(0, programSegment, joints);
+                for (size_t i = 0; i < 4; i++)
+                {
+                    if (std::abs(joints[i] - input.current_position[i]) > ProgramStartTolerance)
+                    {
+                        abortProgram(fmt::format("moveLinear starts {:.3f}° away from J{}",
+                                                 joints[i] - input.current_position[i], i + 1));
+                        return;
+                    }
+                }
+            }
+            if (path.evaluate(instructionCycle, programSegment, joints))
+            {
+                updateOutputs(instructionCycle * dt, (path.length - 1 - instructionCycle) * dt);
+                target.alpha = joints[0];
+                target.beta = joints[1];
+                target.theta = joints[2];
+                target.phi = joints[3];
+                target.space = IK::Space::Joint;
+                instructionCycle++;
+                return;
+            }
+            target = path.end;
+            target.space = IK::Space::Joint;
+            finishOutputs();
+        }
+        break;
+        case Instruction::Op::Dwell:
+            if (++instructionCycle * dt < programValue(instruction) - dt / 2)
+            {
+                return;
+            }
+            break;
+        case Instruction::Op::WaitInput: {
+            auto inputs = Arm.drives[instruction.joint]->getDigitalInputs();
+            if (((inputs & instruction.mask) != 0) != instruction.state)
+            {
+                auto timeout = programValue(instruction);
+                if (timeout > 0 && ++instructionCycle * dt >= timeout)
+                {
+                    abortProgram(fmt::format("Timeout waiting for J{} input {:#x}", instruction.joint + 1,
+                                             instruction.mask));
+                }
+                return;
+            }
+        }
+        break;
+        case Instruction::Op::Payload:
+            if (instruction.state)
+            {
+                gripPayload();
+            }
+            else
+            {
+                setPayload(programValue(instruction));
+            }
+            break;
+        case Instruction::Op::Loop:
+            programCounters[instruction.counter] = int64_t(std::round(programValue(instruction)));
+            if (programCounters[instruction.counter] < 1)
+            {
+                programCounter = instruction.jump;
+                instructionStarted = false;
+                continue;
+            }
+            break;
+        case Instruction::Op::EndLoop:
+            if (--programCounters[instruction.counter] > 0)
+            {
+                programCounter = instruction.jump;
+                instructionStarted = false;
+                continue;
+            }
+            break;
+        case Instruction::Op::End:
+            eventLog.Info(fmt::format("Program {} complete", program->id));
+            retireProgram();
+            status.program.running = false;
+            return;
+        }
+
+        programCounter++;
+        instructionStarted = false;
+        instructionCycle = 0;
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef ROBOT_PROGRAM_HPP
+#define ROBOT_PROGRAM_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "IK/scara.hpp"
+#include "Motion/spline.hpp"
+#include "outputs.hpp"
+
+namespace Robot
+{
+    using json = nlohmann::json;
+
+    //! @brief Compiled motion program instruction
+    struct Instruction
+    {
+        enum class Op
+        {
+            Move,       // Point to point move through the OTG
+            MoveLinear, // Follow a path fitted at compile time
+            Dwell,      // Wait for a time in seconds
+            WaitInput,  // Wait for a drive digital input
+            Payload,    // Estimate the payload just gripped or set a known one
+            Loop,       // Load a loop counter
+            EndLoop,    // Decrement the loop counter and jump back while non zero
+            End,
+        } op;
+
+        IK::Pose pose = {};     // Move target
+        size_t path = 0;        // MoveLinear index into Program::paths
+        double value = 0;       // Dwell time, loop count or wait timeout
+        int parameter = -1;     // Parameter overriding value, -1 if none
+        size_t jump = 0;        // Loop exit or loop body start
+        size_t counter = 0;     // Loop counter slot
+        size_t joint = 0;       // WaitInput drive index
+        uint32_t mask = 0;      // WaitInput digital input mask
+        bool state = true;      // WaitInput expected state, Payload estimate instead of value
+        std::vector<OutputTrigger> outputs; // Outputs switched along a move
+    };
+
+    //! @brief Motion program pre-compiled into a flat instruction array
+    //!
+    //! Linear moves are interpolated and fitted when the program is compiled so running the program
+    //! only walks the instruction array, point to point moves are planned by the OTG as they start.
+    class Program
+    {
+      public:
+        std::string id;
+        std::vector<Instruction> instructions;
+        std::vector<Motion::Spline> paths;
+        std::vector<std::string> parameterNames;
+        std::vector<double> parameters;
+        size_t loops = 0;
+
+        static std::tuple<std::shared_ptr<Program>, std::string> compile(const json &source, double tolerance);
+        int findParameter(const std::string &name) const;
+    };
+} // namespace Robot
+
+#endif
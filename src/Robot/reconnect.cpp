@@ -0,0 +1,77 @@
+#include "fsm.hpp"
+
+//! @brief Recover from a short EtherCAT dropout without an operator
+//!
+//! A dropout forces the emergency stop like any other fault. When the slaves are back in OP the
+//! dropout was short and every joint is where it was last seen, the drives are reset and the
+//! arm resumes where it was: idle, tracking or at the interrupted instruction of its program.
+//! Otherwise the program is dropped and the operator has to reset and start, with a homing if
+//! the joints moved.
+void Robot::FSM::superviseLink()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+    if (!EtherCATFault)
+    {
+        if (!linkLost)
+        {
+            // Last known state, kept until the link drops
+            linkPositions = {J1.getPosition(), J2.getPosition(), J3.getPosition(), J4.getPosition()};
+            return;
+        }
+
+        linkLost = false;
+        auto duration = std::chrono::duration<double>(now - linkLostTimestamp).count();
+        status.ethercat.lastDropout = duration;
+
+        auto moved = 0.0;
+        for (size_t i = 0; i < Arm.drives.size(); i++)
+        {
+            moved = std::max(moved, std::abs(Arm.drives[i]->getPosition() - linkPositions[i]));
+        }
+
+        if (duration > ReconnectTimeout || moved > ReconnectTolerance)
+        {
+            if (moved > ReconnectTolerance)
+            {
+                needsHoming = !SIMULATION;
+            }
+            eventLog.Error(fmt::format("EtherCAT recovered after {:.0f} ms, not resuming: {}", duration * 1000,
+                                       moved > ReconnectTolerance
+                                           ? fmt::format("a joint moved {:.3f}° during the dropout", moved)
+                                           : std::string("dropout too long")));
+            if (holdProgram && program != nullptr)
+            {
+                eventLog.Warning(fmt::format("Program {} interrupted", program->id));
+                retireProgram();
+                status.program.running = false;
+            }
+            holdProgram = false;
+            return;
+        }
+
+        std::string resume = "idle";
+        if (holdProgram && program != nullptr)
+        {
+            resume = fmt::format("program {} at instruction {}", program->id, programCounter);
+        }
+        else if (linkResume)
+        {
+            resume = "tracking";
+        }
+        status.ethercat.recoveries++;
+        eventLog.Info(fmt::format("EtherCAT recovered after {:.0f} ms, resuming {}", duration * 1000, resume));
+        reset = true;
+        run = linkResume;
+        return;
+    }
+
+    if (!linkLost)
+    {
+        linkLost = true;
+        linkLostTimestamp = now;
+        // Only tracking resumes on its own, jogging needs the operator on the deadman
+        linkResume = next == State::Tracking || next == State::Track;
+        holdProgram = linkResume && program != nullptr;
+    }
+}
@@ -18,7 +18,8 @@ void Robot::to_json(json &j, const Preset &p)
     j = json{{"id", p.id},
              {"name", p.name},
              {"axisConfigurations", p.axisConfigurations},
-             {"synchronisationMethod", p.synchronisationMethod}};
+             {"synchronisationMethod", p.synchronisationMethod},
+             {"otgBackend", p.otgBackend}};
 }
 
 void Robot::from_json(const json &j, Preset &p)
@@ -27,6 +28,31 @@ void Robot::from_json(const json &j, Preset &p)
     j.at("name").get_to(p.name);
     j.at("axisConfigurations").get_to(p.axisConfigurations);
     j.at("synchronisationMethod").get_to(p.synchronisationMethod);
+    p.otgBackend = j.value("otgBackend", "profile");
+}
+
+void Robot::to_json(json &j, const FeedforwardSettings &s)
+{
+    j = json{{"velocity", s.velocity}, {"torque", s.torque}};
+}
+
+void Robot::from_json(const json &j, FeedforwardSettings &s)
+{
+    s.velocity = j.value("velocity", std::array<double, 4>{0, 0, 0, 0});
+    s.torque = j.value("torque", std::array<double, 4>{0, 0, 0, 0});
+}
+
+void Robot::to_json(json &j, const LoopSettings &s)
+{
+    j = json{{"position", s.position}, {"velocity", s.velocity}, {"integral", s.integral}, {"limit", s.limit}};
+}
+
+void Robot::from_json(const json &j, LoopSettings &s)
+{
+    s.position = j.value("position", std::array<double, 4>{20, 20, 20, 20});
+    s.velocity = j.value("velocity", std::array<double, 4>{0.5, 0.5, 0.5, 0.5});
+    s.integral = j.value("integral", std::array<double, 4>{10, 10, 10, 10});
+    s.limit = j.value("limit", std::array<double, 4>{100, 100, 100, 100});
 }
 
 void Robot::FSM::updateDynamics(Robot::Preset settings)
@@ -66,6 +92,19 @@ void Robot::FSM::updateDynamics(Robot::Preset settings)
     {
         spdlog::warn("Unknown synchronisation method: {}", settings.synchronisationMethod);
     }
+
+    static std::unordered_map<std::string, Motion::Backend> const BackendTable = {
+        {"ruckig", Motion::Backend::Ruckig}, {"profile", Motion::Backend::Profile}};
+
+    auto backend = BackendTable.find(settings.otgBackend);
+    if (backend != BackendTable.end())
+    {
+        trackingBackend = backend->second;
+    }
+    else
+    {
+        spdlog::warn("Unknown OTG backend: {}", settings.otgBackend);
+    }
 }
 
 void Robot::FSM::setJoggingDynamics()
@@ -85,6 +124,39 @@ void Robot::FSM::setJoggingDynamics()
     input.max_jerk = {100.0, 100.0, 10000.0, 10000.0};
 }
 
+//! @brief Scale the acceleration and jerk limits by the thermal headroom and payload of each motor
+//!
+//! Limits are only handed to the OTG when the scale moved by more than the hysteresis, so a slowly
+//! heating motor doesn't make Ruckig recalculate every cycle.
+void Robot::FSM::boostDynamics()
+{
+    for (size_t i = 0; i < input.degrees_of_freedom; i++)
+    {
+        auto scale = thermal.scale(i) * payloadScale[i];
+        // A fully heated motor at the reference payload always returns to exactly the preset
+        if (std::abs(scale - boost[i]) < BoostHysteresis && scale != 1)
+        {
+            continue;
+        }
+        boost[i] = scale;
+        input.max_acceleration[i] = baseAcceleration[i] * scale;
+        input.max_jerk[i] = baseJerk[i] * scale;
+    }
+}
+
+//! @brief Return to the continuous duty dynamics
+void Robot::FSM::restoreBoost()
+{
+    if (!boosted)
+    {
+        return;
+    }
+    input.max_acceleration = baseAcceleration;
+    input.max_jerk = baseJerk;
+    boost = {1, 1, 1, 1};
+    boosted = false;
+}
+
 void Robot::FSM::restoreDynamics()
 {
     for (size_t i = 0; i <= input.degrees_of_freedom - 1; i++)
@@ -93,4 +165,139 @@ void Robot::FSM::restoreDynamics()
         input.max_acceleration[i] = previousDynamics[i].max_acceleration;
         input.max_jerk[i] = previousDynamics[i].max_jerk;
     }
+}
+
+//! @brief Update the feedforward gains of the drives
+void Robot::FSM::updateFeedforward(Robot::FeedforwardSettings settings)
+{
+    if (run)
+    {
+        spdlog::warn("Not updating feedforward because we're moving");
+        return;
+    }
+
+    for (size_t i = 0; i < Arm.drives.size(); i++)
+    {
+        Arm.drives[i]->setVelocityFeedforward(settings.velocity[i]);
+        Arm.drives[i]->setTorqueFeedforward(settings.torque[i]);
+    }
+}
+
+//! @brief Update the rigid body parameters used for torque feedforward
+void Robot::FSM::updateModel(Dynamics::Parameters parameters)
+{
+    if (run)
+    {
+        spdlog::warn("Not updating the dynamic model because we're moving");
+        return;
+    }
+
+    model.parameters = parameters;
+}
+
+//! @brief Update the gains of the loops run in the controller for CSV and CST
+void Robot::FSM::updateLoop(Robot::LoopSettings settings)
+{
+    if (run)
+    {
+        spdlog::warn("Not updating loop gains because we're moving");
+        return;
+    }
+
+    for (size_t i = 0; i < Arm.drives.size(); i++)
+    {
+        Arm.drives[i]->gains = {
+            .position = settings.position[i],
+            .velocity = settings.velocity[i],
+            .integral = settings.integral[i],
+            .limit = std::max(std::min(settings.limit[i], 100.0), 0.0),
+        };
+    }
+}
+
+//! @brief Load joint compensation tables
+//!
+//! Tables are validated and built here, the control thread swaps them in at the start of a cycle
+//! once it is idle. A joint without a table runs uncompensated.
+//!
+//! @return False while moving, if a table is invalid or the previous tables have not been picked up yet
+bool Robot::FSM::updateCompensation(json settings)
+{
+    if (run)
+    {
+        spdlog::warn("Not updating compensation because we're moving");
+        return false;
+    }
+    if (compensationPending)
+    {
+        spdlog::warn("Not updating compensation because the previous tables are still pending");
+        return false;
+    }
+
+    auto joints = settings.value("joints", json::array());
+    std::array<std::shared_ptr<const Drive::Compensation>, 4> tables;
+    for (size_t i = 0; i < std::min(joints.size(), tables.size()); i++)
+    {
+        if (joints[i].is_null())
+        {
+            continue;
+        }
+        auto table = std::make_shared<Drive::Compensation>(joints[i].get<Drive::Compensation>());
+        if (!table->valid())
+        {
+            eventLog.Warning(fmt::format("Compensation table for J{} rejected", i + 1));
+            return false;
+        }
+        tables[i] = std::move(table);
+    }
+
+    // Releases the tables retired by the previous swap
+    pendingCompensation = std::move(tables);
+    compensationPending = true;
+    return true;
+}
+
+//! @brief Update the collision detection settings
+void Robot::FSM::updateCollision(Dynamics::CollisionSettings settings)
+{
+    if (run)
+    {
+        spdlog::warn("Not updating collision detection because we're moving");
+        return;
+    }
+
+    collision.settings = settings;
+}
+
+//! @brief Update the motor thermal model settings
+void Robot::FSM::updateThermal(Dynamics::ThermalSettings settings)
+{
+    if (run)
+    {
+        spdlog::warn("Not updating the thermal model because we're moving");
+        return;
+    }
+    if (thermalPending)
+    {
+        spdlog::warn("Not updating the thermal model because the previous settings are still pending");
+        return;
+    }
+
+    pendingThermal = settings;
+    thermalPending = true;
+}
+
+//! @brief Update the payload estimation settings
+void Robot::FSM::updatePayload(Dynamics::PayloadSettings settings)
+{
+    if (run)
+    {
+        spdlog::warn("Not updating payload estimation because we're moving");
+        return;
+    }
+
+    payloadEstimator.settings = settings;
+    payloadEstimator.active = false;
+    payloadScale = {1, 1, 1, 1};
+    collision.scale = {1, 1, 1, 1};
 }
\ No newline at end of file
@@ -24,9 +24,28 @@ namespace Robot
         std::string name;
         std::array<OTGSettings, 4> axisConfigurations;
         std::string synchronisationMethod;
+        std::string otgBackend;
     };
     void to_json(json &j, const Preset &p);
     void from_json(const json &j, Preset &p);
+
+    struct FeedforwardSettings
+    {
+        std::array<double, 4> velocity; // Gain per axis on the trajectory velocity, 0 disables
+        std::array<double, 4> torque;   // Gain per axis on the model torque, 0 disables
+    };
+    void to_json(json &j, const FeedforwardSettings &s);
+    void from_json(const json &j, FeedforwardSettings &s);
+
+    struct LoopSettings
+    {
+        std::array<double, 4> position; // 1/s, velocity per degree of position error
+        std::array<double, 4> velocity; // % torque per degree/s of velocity error
+        std::array<double, 4> integral; // 1/s, inverse integral time of the velocity loop
+        std::array<double, 4> limit;    // % torque the loop may command
+    };
+    void to_json(json &j, const LoopSettings &s);
+    void from_json(const json &j, LoopSettings &s);
 } // namespace Robot
 
 #endif
\ No newline at end of file
@@ -2,7 +2,11 @@
 
 void Robot::to_json(json &j, const OTGStatus &p)
 {
-    j = json{{"result", p.result}, {"kinematicResult", p.kinematicResult}};
+    j = json{{"result", p.result},
+             {"kinematicResult", p.kinematicResult},
+             {"backend", p.backend == Motion::Backend::Profile ? "profile" : "ruckig"},
+             {"calculationDuration", p.calculationDuration},
+             {"maxCalculationDuration", p.maxCalculationDuration}};
 }
 
 void Robot::to_json(json &j, const EtherCATStatus &p)
@@ -11,7 +15,10 @@ void Robot::to_json(json &j, const EtherCATStatus &p)
              {"sync0", p.sync0},
              {"compensation", p.compensation},
              {"integral", p.integral},
-             {"state", p.state}};
+             {"state", p.state},
+             {"recoveries", p.recoveries},
+             {"lastDropout", p.lastDropout},
+             {"update", p.update}};
 }
 
 void Robot::to_json(json &j, const MotorStatus &p)
@@ -25,9 +32,72 @@ void Robot::to_json(json &j, const MotorStatus &p)
         {"lastFault", p.lastFault},
         {"actualTorque", p.actualTorque},
         {"followingError", p.followingError},
+        {"mode", p.mode},
+        {"modeDisplay", p.modeDisplay},
+        {"torqueStatistics", p.torqueStatistics},
+        {"followingErrorStatistics", p.followingErrorStatistics},
+        {"velocityStatistics", p.velocityStatistics},
     };
 }
 
+void Robot::to_json(json &j, const ProgramStatus &p)
+{
+    j = json{{"id", p.id}, {"running", p.running}, {"counter", p.counter}};
+}
+
+void Robot::to_json(json &j, const ConveyorStatus &p)
+{
+    j = json{{"valid", p.valid},
+             {"tracking", p.tracking},
+             {"position", p.position},
+             {"velocity", p.velocity},
+             {"sync", p.sync}};
+}
+
+void Robot::to_json(json &j, const CollisionStatus &p)
+{
+    j = json{{"enabled", p.enabled}, {"residual", p.residual}, {"peak", p.peak}};
+}
+
+void Robot::to_json(json &j, const ThermalStatus &p)
+{
+    j = json{{"enabled", p.enabled}, {"load", p.load}, {"headroom", p.headroom}, {"boost", p.boost}};
+}
+
+void Robot::to_json(json &j, const PayloadStatus &p)
+{
+    j = json{{"enabled", p.enabled},
+             {"estimating", p.estimating},
+             {"converged", p.converged},
+             {"mass", p.mass},
+             {"deviation", p.deviation},
+             {"scale", p.scale},
+             {"thresholds", p.thresholds}};
+}
+
+void Robot::to_json(json &j, const IdentificationStatus &p)
+{
+    j = json{{"active", p.active}, {"progress", p.progress}, {"samples", p.samples}};
+}
+
+void Robot::to_json(json &j, const ProbeStatus &p)
+{
+    j = json{{"armed", p.armed}, {"triggered", p.triggered}, {"count", p.count}, {"pose", p.pose}};
+}
+
+void Robot::to_json(json &j, const StreamStatus &p)
+{
+    j = json{{"active", p.active},
+             {"received", p.received},
+             {"dropped", p.dropped},
+             {"rejected", p.rejected},
+             {"interval", p.interval},
+             {"latency", p.latency},
+             {"jitter", p.jitter},
+             {"maxLatency", p.maxLatency},
+             {"age", p.age}};
+}
+
 void Robot::to_json(json &j, const Status &p)
 {
     j = json{
@@ -37,7 +107,17 @@ void Robot::to_json(json &j, const Status &p)
         {"needsHoming", p.needsHoming},
         {"state", p.state},
         {"otg", p.otg},
+        {"program", p.program},
+        {"conveyor", p.conveyor},
+        {"stream", p.stream},
+        {"probe", p.probe},
+        {"collision", p.collision},
+        {"thermal", p.thermal},
+        {"payload", p.payload},
+        {"tune", p.tune},
+        {"identification", p.identification},
         {"ethercat", p.ethercat},
+        {"mailbox", p.mailbox},
         {"drives", p.drives},
         {"diagMsg", p.diagMsg},
         {"pose", p.pose},
@@ -82,6 +162,10 @@ void Robot::FSM::broadcastStatus(natsConnection *nc)
     status.alarm = alarm;
     status.state = to_string();
     status.needsHoming = needsHoming;
+    {
+        std::lock_guard<std::mutex> lock(programMutex);
+        status.program.id = programIds[programStarted % programIds.size()];
+    }
     // status.diagMsg = diagStr;
     status.pose = IK::Pose{
         .x = dx,
@@ -97,6 +181,36 @@ void Robot::FSM::broadcastStatus(natsConnection *nc)
         .thetaVelocity = J3.getVelocity(),
         .phiVelocity = J4.getVelocity(),
     };
+    status.conveyor = {
+        .valid = conveyor.valid,
+        .tracking = conveyorTracking,
+        .position = conveyor.position,
+        .velocity = conveyor.velocity,
+        .sync = conveyorSync,
+    };
+    status.collision = {
+        .enabled = collision.settings.enabled,
+        .residual = collision.residual,
+        .peak = collision.peak,
+    };
+    status.thermal = {
+        .enabled = thermal.settings.enabled,
+        .load = thermal.load,
+        .headroom = thermal.headroom,
+        .boost = boost,
+    };
+    status.payload = {
+        .enabled = payloadEstimator.settings.enabled,
+        .estimating = payloadEstimator.active,
+        .converged = payloadEstimator.converged,
+        .mass = payloadEstimator.mass,
+        .deviation = payloadEstimator.deviation,
+        .scale = payloadScale,
+        .thresholds = collision.scale,
+    };
+    status.mailbox = Drive::mailbox.status();
+    status.stream = stream.status();
+    status.stream.active = streaming;
     status.runtimeDuration = runtimeDuration;
     status.powerOnDuration = powerOnDuration;
 
@@ -106,13 +220,18 @@ void Robot::FSM::broadcastStatus(natsConnection *nc)
     {
         status.drives.push_back({
             .slaveID = drive->slaveID,
-            .statusWord = drive->pdo->getStatusWord(),
+            .statusWord = drive->pdo.getStatusWord(),
             .controlWord = drive->getControlWord(),
-            .errorCode = drive->pdo->getErrorCode(),
+            .errorCode = drive->pdo.getErrorCode(),
             .fault = drive->fault,
             .lastFault = drive->lastFault,
             .actualTorque = drive->getTorque(),
             .followingError = drive->getFollowingError(),
+            .mode = Drive::modeToString(drive->cyclicMode),
+            .modeDisplay = Drive::modeToString(drive->getModeOfOperation()),
+            .torqueStatistics = drive->torqueStatistics.summary(),
+            .followingErrorStatistics = drive->followingErrorStatistics.summary(),
+            .velocityStatistics = drive->velocityStatistics.summary(),
         });
     }
 
@@ -4,6 +4,8 @@
 #include "nlohmann/json.hpp"
 #include "ruckig/ruckig.hpp"
 
+#include "tuning.hpp"
+
 namespace Robot
 {
     using namespace ruckig;
@@ -13,6 +15,9 @@ namespace Robot
     {
         ruckig::Result result;
         IK::Result kinematicResult;
+        Motion::Backend backend;
+        double calculationDuration;    // us
+        double maxCalculationDuration; // us
     };
     void to_json(json &j, const OTGStatus &p);
 
@@ -23,6 +28,9 @@ namespace Robot
         int64_t compensation;
         int64_t integral;
         int64_t state;
+        size_t recoveries = 0;  // Dropouts resumed from without an operator
+        double lastDropout = 0; // s
+        Drive::Summary update;  // us the state machine took per cycle over the last 1000 cycles, peak since start
     };
     void to_json(json &j, const EtherCATStatus &p);
 
@@ -36,9 +44,78 @@ namespace Robot
         std::string lastFault = "OK";
         double actualTorque;
         double followingError;
+        std::string mode;
+        std::string modeDisplay;                 // Mode of operation the drive reports
+        Drive::Summary torqueStatistics;         // % over the last 500 cycles of motion, peak and RMS per move
+        Drive::Summary followingErrorStatistics; // degrees
+        Drive::Summary velocityStatistics;       // degrees/s
     };
     void to_json(json &j, const MotorStatus &p);
 
+    struct ProgramStatus
+    {
+        std::string id;
+        bool running;
+        size_t counter;
+    };
+    void to_json(json &j, const ProgramStatus &p);
+
+    struct ConveyorStatus
+    {
+        bool valid;
+        bool tracking;
+        double position;
+        double velocity;
+        double sync;
+    };
+    void to_json(json &j, const ConveyorStatus &p);
+
+    struct CollisionStatus
+    {
+        bool enabled;
+        std::array<double, 4> residual; // % torque
+        std::array<double, 4> peak;     // % torque since motion started
+    };
+    void to_json(json &j, const CollisionStatus &p);
+
+    struct ThermalStatus
+    {
+        bool enabled;
+        std::array<double, 4> load;     // Winding load, 1 at rated continuous current
+        std::array<double, 4> headroom; // Fraction of the thermal limit left
+        std::array<double, 4> boost;    // Scale applied to the acceleration and jerk limits
+    };
+    void to_json(json &j, const ThermalStatus &p);
+
+    struct PayloadStatus
+    {
+        bool enabled;
+        bool estimating;
+        bool converged;
+        double mass;                      // kg
+        double deviation;                 // kg
+        std::array<double, 4> scale;      // Scale of the acceleration and jerk limits for the payload
+        std::array<double, 4> thresholds; // Scale of the collision thresholds for the payload
+    };
+    void to_json(json &j, const PayloadStatus &p);
+
+    struct IdentificationStatus
+    {
+        bool active;
+        double progress; // Fraction of the excitation done
+        size_t samples;
+    };
+    void to_json(json &j, const IdentificationStatus &p);
+
+    struct ProbeStatus
+    {
+        bool armed;
+        bool triggered; // Last probe move latched
+        size_t count;
+        IK::Pose pose; // Latched position
+    };
+    void to_json(json &j, const ProbeStatus &p);
+
     struct Status
     {
         bool run;
@@ -47,7 +124,17 @@ namespace Robot
         bool needsHoming;
         std::string state;
         OTGStatus otg;
+        ProgramStatus program;
+        ConveyorStatus conveyor;
+        StreamStatus stream;
+        ProbeStatus probe;
+        CollisionStatus collision;
+        ThermalStatus thermal;
+        PayloadStatus payload;
+        TuneStatus tune;
+        IdentificationStatus identification;
         EtherCATStatus ethercat;
+        Drive::MailboxStatus mailbox;
         std::vector<MotorStatus> drives;
         std::string diagMsg;
         IK::Pose pose;
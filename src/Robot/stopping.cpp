@@ -0,0 +1,130 @@
+#include "fsm.hpp"
+
+//! @brief Predict if a controlled stop is needed
+//!
+//! Computes where each axis would come to rest if braking started now and checks the result
+//! against the drive soft limits and the base keep out zone. Braking must start while there is
+//! still room, the forward kinematic test in tracking only catches a crash once it is imminent.
+//!
+//! @return True if the robot should begin a controlled stop
+bool Robot::FSM::brakingLimit()
+{
+    std::array<double, 4> stop;
+    for (size_t i = 0; i < 4; i++)
+    {
+        stop[i] = input.current_position[i] + Motion::brakingDistance(input.current_velocity[i],
+                                                                      input.current_acceleration[i],
+                                                                      input.max_acceleration[i], input.max_jerk[i]);
+        auto &drive = Arm.drives[i];
+        if (stop[i] < drive->minPosition || stop[i] > drive->maxPosition)
+        {
+            stopReason = fmt::format("J{} stopping position {:.3f} outside soft limits", drive->slaveID, stop[i]);
+            return true;
+        }
+    }
+
+    auto [alpha, beta, theta, phi, postResult] = IK::postprocessing(stop[0], stop[1], stop[2], stop[3]);
+    if (postResult == IK::Result::ForwardKinematic)
+    {
+        stopReason = "Stopping position inside keep out zone";
+        return true;
+    }
+
+    return false;
+}
+
+//! @brief Configure a controlled stop
+//!
+//! Switches the OTG to the velocity interface with a zero target so Ruckig brakes every axis as
+//! fast as the current dynamics allow, queued paths and the running program are discarded.
+void Robot::FSM::configureStop()
+{
+    eventLog.Warning(fmt::format("Controlled stop: {}", stopReason));
+
+    previousSynchronization = input.synchronization;
+    input.control_interface = ControlInterface::Velocity;
+    input.synchronization = Synchronization::None;
+    input.target_velocity = {0.0, 0.0, 0.0, 0.0};
+    input.target_acceleration = {0.0, 0.0, 0.0, 0.0};
+    otg.reset();
+
+    paths.clear();
+    pathOutputs.clear();
+    moveOutputs = nullptr;
+    pathCycle = 0;
+    pathSegment = 0;
+    if (program != nullptr)
+    {
+        eventLog.Warning(fmt::format("Program {} interrupted", program->id));
+        retireProgram();
+        status.program.running = false;
+    }
+    if (probe != Probe::Idle)
+    {
+        eventLog.Warning("Probe move interrupted");
+        disarmProbe();
+    }
+}
+
+//! @brief Bring the robot to rest with the drives enabled
+//!
+//! @return True if the stop encountered an error and the drives must be disabled
+bool Robot::FSM::stopping()
+{
+    updateOTG();
+    auto &p = output.new_position;
+    auto &v = output.new_velocity;
+    auto t = model.torque(p, v, output.new_acceleration);
+    if (collided(t))
+    {
+        return true;
+    }
+
+    auto [d1, d2, d3, d4, postResult] = IK::postprocessing(p[0], p[1], p[2], p[3]);
+    if (postResult == IK::Result::ForwardKinematic)
+    {
+        KinematicAlarm = true;
+        eventLog.Error("Forward kinematic test detected imminent crash while stopping", dump());
+        return true;
+    }
+
+    if (J1.move(d1, v[0], t[0]) || J2.move(d2, v[1], t[1]) || J3.move(d3, v[2], t[2]) || J4.move(d4, v[3], t[3]))
+    {
+        for (auto &&drive : Arm.drives)
+        {
+            if (drive->fault)
+            {
+                eventLog.Error("J" + std::to_string(drive->slaveID) + " " + drive->lastFault, dump());
+            }
+        }
+        return true;
+    }
+
+    output.pass_to_input(input);
+
+    return false;
+}
+
+//! @brief Restore position control and hold where the robot came to rest
+void Robot::FSM::releaseStop()
+{
+    input.control_interface = ControlInterface::Position;
+    input.synchronization = previousSynchronization;
+    input.target_velocity = {0.0, 0.0, 0.0, 0.0};
+    input.target_acceleration = {0.0, 0.0, 0.0, 0.0};
+
+    auto &p = input.current_position;
+    auto [x, y, z, r] = IK::forwardKinematics(p[0], p[1], p[2], p[3], target.toolOffset);
+    target = {
+        .x = x,
+        .y = y,
+        .z = z,
+        .r = r,
+        .alpha = p[0],
+        .beta = p[1],
+        .theta = p[2],
+        .phi = p[3],
+        .toolOffset = target.toolOffset,
+        .space = IK::Space::Joint,
+    };
+}
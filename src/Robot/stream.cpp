@@ -0,0 +1,200 @@
+#include "stream.hpp"
+#include "fsm.hpp"
+
+//! @brief Forget the previous stream
+void Robot::TargetStream::reset()
+{
+    initialised = false;
+
+    std::lock_guard<std::mutex> lock(estimateMutex);
+    statistics = {};
+    age = 0;
+    updated = false;
+    valid = false;
+}
+
+//! @brief Add a streamed target to the estimate
+//!
+//! @param pose Target position
+//! @param timestamp Time the target was sampled at the source in ns since the epoch
+//! @param now Arrival time on the clock the targets are extrapolated with, in ns since the epoch
+//! @param velocity Target velocity in mm/s and degrees/s if the source measured it
+//! @return False if the message was rejected
+bool Robot::TargetStream::receive(const IK::Pose &pose, int64_t timestamp, int64_t now,
+                                  const std::array<double, 4> *velocity)
+{
+    auto latency = (now - timestamp) / 1e6;
+
+    // The control thread only ever tries the lock, holding it here never blocks the cycle
+    std::lock_guard<std::mutex> lock(estimateMutex);
+
+    if (latency > maxAge * 1e3 || (initialised && timestamp <= filter.timestamp))
+    {
+        statistics.rejected++;
+        return false;
+    }
+
+    statistics.received++;
+    if (statistics.received == 1)
+    {
+        statistics.latency = latency;
+    }
+    statistics.jitter += (std::abs(latency - statistics.latency) - statistics.jitter) / 16;
+    statistics.latency += (latency - statistics.latency) / 16;
+    statistics.maxLatency = std::max(statistics.maxLatency, latency);
+
+    std::array<double, 4> measured = {pose.x, pose.y, pose.z, pose.r};
+    if (!initialised)
+    {
+        filter = {.position = measured, .velocity = {0, 0, 0, 0}, .timestamp = timestamp};
+        if (velocity != nullptr)
+        {
+            filter.velocity = *velocity;
+        }
+        initialised = true;
+    }
+    else
+    {
+        auto dt = (timestamp - filter.timestamp) / double(TS::NSEC_PER_SECOND);
+        auto interval = dt * 1e3;
+        if (statistics.interval == 0)
+        {
+            statistics.interval = interval;
+        }
+        else if (interval > 1.5 * statistics.interval)
+        {
+            statistics.dropped += uint64_t(std::round(interval / statistics.interval)) - 1;
+        }
+        else
+        {
+            statistics.interval += (interval - statistics.interval) / 16;
+        }
+
+        // Predict to the new sample then correct by the residual
+        for (size_t i = 0; i < 4; i++)
+        {
+            auto predicted = filter.position[i] + filter.velocity[i] * dt;
+            auto residual = measured[i] - predicted;
+            filter.position[i] = predicted + alpha * residual;
+            if (velocity != nullptr)
+            {
+                filter.velocity[i] += alpha * ((*velocity)[i] - filter.velocity[i]);
+            }
+            else
+            {
+                filter.velocity[i] += beta * residual / dt;
+            }
+        }
+        filter.timestamp = timestamp;
+    }
+
+    pending = filter;
+    updated = true;
+
+    return true;
+}
+
+//! @brief Extrapolate the estimate to a point in time
+//!
+//! Called from the control thread, a new estimate is only picked up if the receiving thread isn't
+//! holding it so the cycle never blocks.
+//!
+//! @param time Time to extrapolate to in ns since the epoch
+//! @param position Extrapolated target position
+//! @param velocity Target velocity, zero once the stream has gone quiet
+//! @return False if there is no estimate yet
+bool Robot::TargetStream::extrapolate(int64_t time, std::array<double, 4> &position, std::array<double, 4> &velocity)
+{
+    if (estimateMutex.try_lock())
+    {
+        if (updated)
+        {
+            estimate = pending;
+            updated = false;
+            valid = true;
+        }
+        estimateMutex.unlock();
+    }
+    if (!valid)
+    {
+        return false;
+    }
+
+    // A stream that has gone quiet holds the last extrapolated point
+    auto elapsed = (time - estimate.timestamp) / double(TS::NSEC_PER_SECOND);
+    auto stale = elapsed > maxExtrapolation;
+    elapsed = std::max(std::min(elapsed, maxExtrapolation), 0.0);
+    age = elapsed * 1e3;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        position[i] = estimate.position[i] + estimate.velocity[i] * elapsed;
+        velocity[i] = stale ? 0.0 : estimate.velocity[i];
+    }
+
+    return true;
+}
+
+//! @brief Stream statistics for the status broadcast
+Robot::StreamStatus Robot::TargetStream::status()
+{
+    std::lock_guard<std::mutex> lock(estimateMutex);
+    auto status = statistics;
+    status.age = age;
+    return status;
+}
+
+//! @brief Follow the distributed clock with the wall clock offset
+//!
+//! Called by the control thread after each frame. The reference clock latched the frame shortly
+//! before, the offset is smoothed over that delay. The drives execute targets on the distributed
+//! clock, which the control loop is locked to through the DC sync offset.
+void Robot::FSM::syncStreamClock()
+{
+    if (ec_DCtime <= 0)
+    {
+        return;
+    }
+    auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+    auto offset = ec_DCtime + DCEpoch - wall;
+    auto current = streamOffset.load();
+    // Jump on the first frame or after the wall clock was stepped
+    if (current == 0 || std::abs(offset - current) > int64_t(TS::NSEC_PER_SECOND) / 100)
+    {
+        streamOffset = offset;
+        return;
+    }
+    streamOffset = current + (offset - current) / 16;
+}
+
+//! @brief Current time on the distributed clock in ns since the Unix epoch
+//!
+//! Falls back to the wall clock until the bus has run, safe to call from any thread.
+int64_t Robot::FSM::streamClock() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+               .count() +
+           streamOffset;
+}
+
+//! @brief Streamed target extrapolated to the cycle the drives will execute it in
+//!
+//! @param pose Target to replace the position of
+//! @param velocity Cartesian target velocity
+void Robot::FSM::streamPose(IK::Pose &pose, std::array<double, 4> &velocity)
+{
+    // The target computed now goes out with the next frame
+    auto time = streamClock() + int64_t(CYCLETIME);
+
+    std::array<double, 4> position;
+    if (stream.extrapolate(time, position, velocity))
+    {
+        pose.x = position[0];
+        pose.y = position[1];
+        pose.z = position[2];
+        pose.r = position[3];
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef ROBOT_STREAM_HPP
+#define ROBOT_STREAM_HPP
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+#include "IK/scara.hpp"
+
+namespace Robot
+{
+    using json = nlohmann::json;
+
+    struct StreamStatus
+    {
+        bool active;
+        uint64_t received;
+        uint64_t dropped;  // Messages missing from the stream judging by the usual interval
+        uint64_t rejected; // Messages arriving out of order or too late to use
+        double interval;   // ms between source timestamps
+        double latency;    // ms from source timestamp to arrival
+        double jitter;     // ms mean deviation of latency
+        double maxLatency; // ms
+        double age;        // ms the current target was extrapolated over
+    };
+    void to_json(json &j, const StreamStatus &p);
+
+    //! @brief Streamed cartesian target estimator
+    //!
+    //! Timestamped targets are smoothed with an alpha-beta filter in source time as they arrive,
+    //! the control thread then extrapolates the estimate to the cycle the drives will execute it in
+    //! so a moving target is followed without lag.
+    class TargetStream
+    {
+      public:
+        double alpha = 0.5;             // Position correction gain
+        double beta = 0.2;              // Velocity correction gain
+        double maxAge = 0.5;            // Oldest usable message in seconds
+        double maxExtrapolation = 0.05; // Longest extrapolation before the target is held in seconds
+
+        void reset();
+        bool receive(const IK::Pose &pose, int64_t timestamp, int64_t now, const std::array<double, 4> *velocity);
+        bool extrapolate(int64_t time, std::array<double, 4> &position, std::array<double, 4> &velocity);
+        StreamStatus status();
+
+      private:
+        struct Estimate
+        {
+            std::array<double, 4> position;
+            std::array<double, 4> velocity;
+            int64_t timestamp; // ns since the epoch
+        };
+
+        // Filter state, only touched by the receiving thread
+        Estimate filter = {};
+        bool initialised = false;
+
+        std::mutex estimateMutex;
+        StreamStatus statistics = {};
+        std::atomic<double> age = 0; // ms, written by the control thread without the lock
+        Estimate pending = {};
+        Estimate estimate = {};
+        bool updated = false;
+        bool valid = false;
+    };
+} // namespace Robot
+
+#endif
@@ -24,35 +24,92 @@ bool Robot::FSM::tracking()
         inSync = true;
     }
 
-    auto [fx, fy, fz, fr, preResult] = IK::preprocessing(target.x, target.y, target.z, target.r);
-    status.otg.kinematicResult = preResult;
-    if (preResult == IK::Result::JointLimit && !KinematicAlarm)
+    if (conveyorTracking && !conveyor.valid)
     {
-        eventLog.Kinematic("Joint limit exceeded during preprocessing", dump());
+        conveyorTracking = false;
+        stopReason = "Conveyor signal lost";
+        stopRequest = true;
     }
 
-    auto [alpha, beta, theta, phi, ikResult] = IK::inverseKinematics(fx, fy, fz, fr, target.toolOffset);
-    status.otg.kinematicResult = (preResult != IK::Result::Success ? preResult : ikResult);
-
-    if (ikResult != IK::Result::Singularity)
-    {
-        input.target_position[0] = alpha;
-        input.target_position[1] = beta;
-        input.target_position[2] = theta;
-        input.target_position[3] = phi;
-    }
-    if (ikResult == IK::Result::JointLimit && !KinematicAlarm)
+    if (target.space == IK::Space::Joint)
     {
-        eventLog.Kinematic("Joint limit exceeded during kinematic step", dump());
+        // Joint space targets skip inverse kinematics and are only forward checked by postprocessing
+        auto [alpha, beta, theta, phi, limitResult] = IK::jointLimits(target.alpha, target.beta, target.theta,
+                                                                      target.phi);
+        status.otg.kinematicResult = limitResult;
+        if (limitResult == IK::Result::JointLimit && !KinematicAlarm)
+        {
+            eventLog.Kinematic("Joint limit exceeded by joint space target", dump());
+        }
+        KinematicAlarm = limitResult != IK::Result::Success;
+
+        input.target_position = {alpha, beta, theta, phi};
+        input.target_velocity = {0.0, 0.0, 0.0, 0.0};
     }
-    if (ikResult == IK::Result::Singularity && !KinematicAlarm)
+    else
     {
-        eventLog.Kinematic("Singularity detected", dump());
+        // Conveyor frame targets move with the belt, streamed targets are extrapolated to this cycle
+        auto pose = target;
+        std::array<double, 4> velocity = {0.0, 0.0, 0.0, 0.0};
+        if (conveyorTracking)
+        {
+            pose = conveyorPose();
+            velocity = conveyorVelocity();
+        }
+        else if (streaming)
+        {
+            streamPose(pose, velocity);
+        }
+        auto [fx, fy, fz, fr, preResult] = IK::preprocessing(pose.x, pose.y, pose.z, pose.r);
+        status.otg.kinematicResult = preResult;
+        if (preResult == IK::Result::JointLimit && !KinematicAlarm)
+        {
+            eventLog.Kinematic("Joint limit exceeded during preprocessing", dump());
+        }
+
+        auto [alpha, beta, theta, phi, ikResult] = IK::inverseKinematics(fx, fy, fz, fr, target.toolOffset);
+        status.otg.kinematicResult = (preResult != IK::Result::Success ? preResult : ikResult);
+
+        if (ikResult != IK::Result::Singularity)
+        {
+            input.target_position[0] = alpha;
+            input.target_position[1] = beta;
+            input.target_position[2] = theta;
+            input.target_position[3] = phi;
+        }
+
+        // Moving targets are reached at their own velocity instead of at rest
+        input.target_velocity = {0.0, 0.0, 0.0, 0.0};
+        if (ikResult == IK::Result::Success)
+        {
+            auto [da, db, dt, dp, jacobianResult] = IK::jointVelocity(
+                alpha, beta, fr, velocity[0], velocity[1], velocity[2], velocity[3], target.toolOffset);
+            if (jacobianResult == IK::Result::Success)
+            {
+                input.target_velocity = {da, db, dt, dp};
+            }
+        }
+        if (ikResult == IK::Result::JointLimit && !KinematicAlarm)
+        {
+            eventLog.Kinematic("Joint limit exceeded during kinematic step", dump());
+        }
+        if (ikResult == IK::Result::Singularity && !KinematicAlarm)
+        {
+            eventLog.Kinematic("Singularity detected", dump());
+        }
+        KinematicAlarm = preResult != IK::Result::Success || ikResult != IK::Result::Success;
     }
-    KinematicAlarm = preResult != IK::Result::Success || ikResult != IK::Result::Success;
 
-    status.otg.result = otg.update(input, output);
+    updateOTG();
     auto &p = output.new_position;
+    auto &v = output.new_velocity;
+    auto t = model.torque(p, v, output.new_acceleration);
+    if (collided(t))
+    {
+        run = false;
+        return true;
+    }
+    estimatePayload(p, v, output.new_acceleration, t);
 
     auto [d1, d2, d3, d4, postResult] = IK::postprocessing(p[0], p[1], p[2], p[3]);
     if (postResult == IK::Result::ForwardKinematic)
@@ -63,7 +120,7 @@ bool Robot::FSM::tracking()
         return true;
     }
 
-    if (J1.move(d1) || J2.move(d2) || J3.move(d3) || J4.move(d4))
+    if (J1.move(d1, v[0], t[0]) || J2.move(d2, v[1], t[1]) || J3.move(d3, v[2], t[2]) || J4.move(d4, v[3], t[3]))
     {
         for (auto &&drive : Arm.drives)
         {
@@ -80,4 +137,24 @@ bool Robot::FSM::tracking()
     output.pass_to_input(input);
 
     return false;
-}
\ No newline at end of file
+}
+
+//! @brief Check the torque residuals for a collision
+//!
+//! @param expected Model torque for the commanded trajectory in %
+//! @return True if a joint collided and the drives must be disabled this cycle
+bool Robot::FSM::collided(const std::array<double, 4> &expected)
+{
+    std::array<double, 4> measured = {J1.getTorque(), J2.getTorque(), J3.getTorque(), J4.getTorque()};
+    auto joint = collision.update(expected, measured, CYCLETIME / double(TS::NSEC_PER_SECOND));
+    if (joint < 0)
+    {
+        return false;
+    }
+
+    eventLog.Error(fmt::format("Collision detected on J{}, torque residual {:.1f}% over {:.1f}%", joint + 1,
+                               collision.residual[joint],
+                               collision.settings.thresholds[joint] * collision.scale[joint]),
+                   dump());
+    return true;
+}
@@ -0,0 +1,355 @@
+#include "tuning.hpp"
+#include "fsm.hpp"
+
+namespace
+{
+    const char *const TuneLimitNames[] = {"max-velocity", "max-acceleration", "max-jerk"};
+} // namespace
+
+void Robot::to_json(json &j, const TuneSettings &s)
+{
+    j = json{{"id", s.id},
+             {"name", s.name},
+             {"center", s.center},
+             {"distance", s.distance},
+             {"followingError", s.followingError},
+             {"torque", s.torque},
+             {"maxScale", s.maxScale},
+             {"iterations", s.iterations},
+             {"synchronisationMethod", s.synchronisationMethod}};
+}
+
+void Robot::from_json(const json &j, TuneSettings &s)
+{
+    j.at("id").get_to(s.id);
+    s.name = j.value("name", s.id);
+    j.at("center").get_to(s.center);
+    j.at("distance").get_to(s.distance);
+    j.at("followingError").get_to(s.followingError);
+    j.at("torque").get_to(s.torque);
+    s.maxScale = j.value("maxScale", 4.0);
+    s.iterations = j.value("iterations", size_t(6));
+    s.synchronisationMethod = j.value("synchronisationMethod", "time");
+}
+
+void Robot::to_json(json &j, const TuneStatus &p)
+{
+    j = json{{"active", p.active},
+             {"joint", p.joint},
+             {"limit", p.active ? TuneLimitNames[p.limit] : ""},
+             {"iteration", p.iteration},
+             {"value", p.value},
+             {"followingError", p.followingError},
+             {"torque", p.torque}};
+}
+
+namespace
+{
+    double &limitOf(Robot::OTGSettings &settings, size_t limit)
+    {
+        switch (limit)
+        {
+        case 0:
+            return settings.max_velocity;
+        case 1:
+            return settings.max_acceleration;
+        default:
+            return settings.max_jerk;
+        }
+    }
+} // namespace
+
+//! @brief Check an autotune request and queue it
+//!
+//! The characteristic moves must stay inside the soft limits and clear of the base.
+//!
+//! @return False if the request was rejected
+bool Robot::FSM::queueTuning(const TuneSettings &settings)
+{
+    if (settings.iterations == 0 || settings.iterations > 20 || settings.maxScale <= 1 ||
+        settings.followingError <= 0 || settings.torque <= 0)
+    {
+        eventLog.Warning("Autotune rejected, invalid budget or search range");
+        return false;
+    }
+
+    auto moving = false;
+    for (size_t i = 0; i < Arm.drives.size(); i++)
+    {
+        auto drive = Arm.drives[i];
+        auto end = settings.center[i] + settings.distance[i];
+        if (settings.distance[i] < 0 || settings.center[i] < drive->minPosition ||
+            settings.center[i] > drive->maxPosition || end < drive->minPosition || end > drive->maxPosition)
+        {
+            eventLog.Warning(fmt::format("Autotune rejected, J{} moves outside its soft limits", i + 1));
+            return false;
+        }
+        moving = moving || settings.distance[i] > 0;
+
+        auto extent = settings.center;
+        extent[i] = end;
+        auto [a, b, t, p, result] = IK::postprocessing(extent[0], extent[1], extent[2], extent[3]);
+        if (result != IK::Result::Success)
+        {
+            eventLog.Warning(fmt::format("Autotune rejected, J{} move comes too close to the base", i + 1));
+            return false;
+        }
+    }
+    if (!moving)
+    {
+        eventLog.Warning("Autotune rejected, no joint to tune");
+        return false;
+    }
+
+    tuneSettings = settings;
+    tune = true;
+    return true;
+}
+
+//! @brief Start autotuning from the active preset
+void Robot::FSM::configureTuning()
+{
+    for (size_t i = 0; i < input.degrees_of_freedom; i++)
+    {
+        tuneBase[i] = {input.max_velocity[i], input.max_acceleration[i], input.max_jerk[i]};
+    }
+    tuneResult = tuneBase;
+    tuneJoint = 0;
+    while (tuneJoint < 4 && tuneSettings.distance[tuneJoint] == 0)
+    {
+        tuneJoint++;
+    }
+    tuneLimit = 0;
+    tuneIteration = 0;
+    tuneLow = limitOf(tuneBase[tuneJoint], tuneLimit);
+    tuneHigh = tuneLow * tuneSettings.maxScale;
+    tunePhase = TunePhase::Center;
+
+    input.control_interface = ControlInterface::Position;
+    input.target_velocity = {0.0, 0.0, 0.0, 0.0};
+    input.target_acceleration = {0.0, 0.0, 0.0, 0.0};
+
+    status.tune = {.active = true, .joint = tuneJoint + 1, .limit = tuneLimit};
+    eventLog.Info(fmt::format("Autotune {} started", tuneSettings.id));
+}
+
+//! @brief Start the next characteristic move with the limit half way through the search range
+void Robot::FSM::startTrial()
+{
+    tuneValue = (tuneLow + tuneHigh) / 2;
+    auto limits = tuneResult[tuneJoint];
+    limitOf(limits, tuneLimit) = tuneValue;
+    input.max_velocity[tuneJoint] = limits.max_velocity;
+    input.max_acceleration[tuneJoint] = limits.max_acceleration;
+    input.max_jerk[tuneJoint] = limits.max_jerk;
+
+    tuneFailed = false;
+    tuneFollowingError = 0;
+    tuneTorque = 0;
+    tunePeak = 0;
+    tuneAcceleration = 0;
+    tunePhase = TunePhase::Out;
+
+    status.tune.joint = tuneJoint + 1;
+    status.tune.limit = tuneLimit;
+    status.tune.iteration = tuneIteration;
+    status.tune.value = tuneValue;
+}
+
+//! @brief Narrow the search range by the result of the last trial and pick the next one
+//!
+//! A trial that stays within budget only counts if the joint came close to the limit under test.
+//! A move too short to reach it says nothing about the limit, and neither would a higher one, so
+//! the range is narrowed from above without raising the result.
+//!
+//! @return True once every joint and limit has been searched
+bool Robot::FSM::evaluateTrial()
+{
+    auto reached = tunePeak >= TuneReach * tuneValue;
+    status.tune.followingError = tuneFollowingError;
+    status.tune.torque = tuneTorque;
+    eventLog.Debug(fmt::format("Autotune J{} {} {:.1f}: {} following error {:.4f}° torque {:.1f}% peak {:.1f}",
+                               tuneJoint + 1, TuneLimitNames[tuneLimit], tuneValue,
+                               tuneFailed ? "over budget"
+                               : reached  ? "within budget"
+                                          : "out of reach",
+                               tuneFollowingError, tuneTorque, tunePeak));
+    if (tuneFailed || !reached)
+    {
+        tuneHigh = tuneValue;
+    }
+    else
+    {
+        tuneLow = tuneValue;
+    }
+
+    if (++tuneIteration < tuneSettings.iterations)
+    {
+        startTrial();
+        return false;
+    }
+
+    // The highest limit seen within budget, the preset value if none was
+    limitOf(tuneResult[tuneJoint], tuneLimit) = tuneLow;
+    tuneIteration = 0;
+    if (++tuneLimit > 2)
+    {
+        // Later joints are tuned with this one back at its preset
+        input.max_velocity[tuneJoint] = tuneBase[tuneJoint].max_velocity;
+        input.max_acceleration[tuneJoint] = tuneBase[tuneJoint].max_acceleration;
+        input.max_jerk[tuneJoint] = tuneBase[tuneJoint].max_jerk;
+
+        tuneLimit = 0;
+        do
+        {
+            tuneJoint++;
+        } while (tuneJoint < 4 && tuneSettings.distance[tuneJoint] == 0);
+        if (tuneJoint >= 4)
+        {
+            return true;
+        }
+    }
+    tuneLow = limitOf(tuneResult[tuneJoint], tuneLimit);
+    tuneHigh = tuneLow * tuneSettings.maxScale;
+    startTrial();
+    return false;
+}
+
+//! @brief Run the characteristic moves of the autotune
+//!
+//! Each trial moves one joint out by its distance and back with the limit being searched. The
+//! following error and torque of that joint are recorded, a trial going over budget turns back at
+//! once and lowers the search range.
+//!
+//! @return True if the autotune encountered an error and the drives must be disabled
+bool Robot::FSM::tuning()
+{
+    if (!inSync)
+    {
+        input.current_position = {
+            J1.getPosition(),
+            J2.getPosition(),
+            J3.getPosition(),
+            J4.getPosition(),
+        };
+        input.current_velocity = {
+            J1.getVelocity(),
+            J2.getVelocity(),
+            J3.getVelocity(),
+            J4.getVelocity(),
+        };
+        input.current_acceleration = {0.0, 0.0};
+        otg.reset();
+
+        eventLog.Kinematic("Resync OTG to actual position");
+        inSync = true;
+    }
+
+    if (tunePhase != TunePhase::Center)
+    {
+        auto drive = Arm.drives[tuneJoint];
+        tuneFollowingError = std::max(tuneFollowingError, std::abs(drive->getFollowingError()));
+        tuneTorque = std::max(tuneTorque, std::abs(drive->getTorque()));
+        if (!tuneFailed && (tuneFollowingError > tuneSettings.followingError || tuneTorque > tuneSettings.torque))
+        {
+            tuneFailed = true;
+            tunePhase = TunePhase::Back;
+        }
+    }
+
+    input.target_position = tuneSettings.center;
+    if (tunePhase == TunePhase::Out)
+    {
+        input.target_position[tuneJoint] += tuneSettings.distance[tuneJoint];
+    }
+
+    auto result = updateOTG();
+    auto &p = output.new_position;
+    auto &v = output.new_velocity;
+    auto t = model.torque(p, v, output.new_acceleration);
+    if (collided(t))
+    {
+        run = false;
+        return true;
+    }
+
+    if (J1.move(p[0], v[0], t[0]) || J2.move(p[1], v[1], t[1]) || J3.move(p[2], v[2], t[2]) ||
+        J4.move(p[3], v[3], t[3]))
+    {
+        for (auto &&drive : Arm.drives)
+        {
+            if (drive->fault)
+            {
+                eventLog.Error("J" + std::to_string(drive->slaveID) + " " + drive->lastFault, dump());
+            }
+        }
+        run = false;
+        return true;
+    }
+
+    if (tunePhase != TunePhase::Center)
+    {
+        auto dt = CYCLETIME / double(TS::NSEC_PER_SECOND);
+        auto acceleration = output.new_acceleration[tuneJoint];
+        auto reached = tuneLimit == 0   ? v[tuneJoint]
+                       : tuneLimit == 1 ? acceleration
+                                        : (acceleration - tuneAcceleration) / dt;
+        tunePeak = std::max(tunePeak, std::abs(reached));
+        tuneAcceleration = acceleration;
+    }
+
+    output.pass_to_input(input);
+
+    if (result == ruckig::Result::Finished)
+    {
+        switch (tunePhase)
+        {
+        case TunePhase::Center:
+            startTrial();
+            break;
+        case TunePhase::Out:
+            tunePhase = TunePhase::Back;
+            break;
+        case TunePhase::Back:
+            if (evaluateTrial())
+            {
+                finishTuning(true);
+            }
+            break;
+        }
+    }
+
+    return false;
+}
+
+//! @brief Restore the preset and hand over the result
+//!
+//! @param complete True if every limit was searched and the result should be stored
+void Robot::FSM::finishTuning(bool complete)
+{
+    for (size_t i = 0; i < input.degrees_of_freedom; i++)
+    {
+        input.max_velocity[i] = tuneBase[i].max_velocity;
+        input.max_acceleration[i] = tuneBase[i].max_acceleration;
+        input.max_jerk[i] = tuneBase[i].max_jerk;
+    }
+    tune = false;
+    status.tune.active = false;
+
+    if (!complete)
+    {
+        eventLog.Warning(fmt::format("Autotune {} interrupted", tuneSettings.id));
+        return;
+    }
+
+    tunedPreset = {
+        .id = tuneSettings.id,
+        .name = tuneSettings.name,
+        .axisConfigurations = tuneResult,
+        .synchronisationMethod = tuneSettings.synchronisationMethod,
+        .otgBackend = "profile",
+    };
+    tunePending = true;
+    eventLog.Info(fmt::format("Autotune {} complete", tuneSettings.id), tunedPreset);
+    run = false;
+}
@@ -0,0 +1,41 @@
+#ifndef ROBOT_TUNING_HPP
+#define ROBOT_TUNING_HPP
+
+#include <array>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+namespace Robot
+{
+    using json = nlohmann::json;
+
+    struct TuneSettings
+    {
+        std::string id; // Preset written with the result
+        std::string name;
+        std::array<double, 4> center;   // Joint position the characteristic moves start from in degrees
+        std::array<double, 4> distance; // Length of the characteristic move per joint in degrees, 0 skips a joint
+        double followingError;          // Budget in degrees
+        double torque;                  // Budget in %
+        double maxScale;                // Highest multiple of the active preset tried
+        size_t iterations;              // Bisection steps per limit
+        std::string synchronisationMethod;
+    };
+    void to_json(json &j, const TuneSettings &s);
+    void from_json(const json &j, TuneSettings &s);
+
+    struct TuneStatus
+    {
+        bool active;
+        size_t joint;
+        size_t limit; // Limit being searched, velocity, acceleration or jerk
+        size_t iteration;
+        double value;          // Limit being tried
+        double followingError; // Largest following error of the last trial in degrees
+        double torque;         // Largest torque of the last trial in %
+    };
+    void to_json(json &j, const TuneStatus &p);
+} // namespace Robot
+
+#endif
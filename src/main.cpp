@@ -189,17 +189,17 @@ int main()
     }
 
     // Setup drive PDO objects
-    std::map<int, std::unique_ptr<Drive::PDO>> pdo;
+    std::map<int, Drive::PDO> pdo;
     for (int i = 0; i < 4; i++)
     {
-        if (!SIMULATION && slaveID[i] != 0)
+        auto slave = SIMULATION ? 0 : slaveID[i];
+        auto drive = Drive::PDO::attach(slave);
+        if (!drive)
         {
-            pdo[slaveID[i]] = std::make_unique<Delta::PDO>(slaveID[i]);
-        }
-        else
-        {
-            pdo[i + 1] = std::make_unique<Sim::PDO>();
+            spdlog::critical("J{} is missing from the bus, build with ROBOTCTRL_MIXED_BUS to simulate it", i + 1);
+            return 1;
         }
+        pdo.insert_or_assign(slave != 0 ? slave : i + 1, std::move(*drive));
     }
 
     // Assign slave ids and setup PDO table
@@ -211,6 +211,15 @@ int main()
     // Assign drive groups
     fsm.Arm = Drive::Group{&fsm.J1, &fsm.J2, &fsm.J3, &fsm.J4};
 
+    // SDO transfers run off the cyclic thread, read the error register and current alarm (P0-01) of
+    // every drive along the way
+    for (auto &&drive : fsm.Arm.drives)
+    {
+        Drive::mailbox.diagnose(drive->slaveID, 0x1001, 0, sizeof(uint8_t));
+        Drive::mailbox.diagnose(drive->slaveID, 0x2001, 0, sizeof(uint16_t));
+    }
+    auto mailbox = std::thread(&Drive::Mailbox::run, &Drive::mailbox, &fsm.shutdown);
+
     // Setup message bus
     auto monitor = std::thread(NC::Monitor, "nats://192.168.0.120:4222", &fsm);
 
@@ -231,6 +240,7 @@ int main()
     int64_t integral = 0;
     clock_gettime(CLOCK_MONOTONIC, &tick);
     TS::Increment(tick, CYCLETIME);
+    Drive::WindowStatistics<1000> updateStatistics;
 
     // Cyclic loop
     while (true)
@@ -238,7 +248,10 @@ int main()
         ec_send_processdata();
         wkc = ec_receive_processdata(EC_TIMEOUTRET);
 
+        auto updateStart = std::chrono::steady_clock::now();
         fsm.update();
+        updateStatistics.push(
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - updateStart).count());
         if (fsm.shutdown && (fsm.next == Robot::FSM::State::Idle ||
                              (std::chrono::system_clock::now().time_since_epoch() - haltTimestamp) > HALT_TIMEOUT))
         {
@@ -246,6 +259,7 @@ int main()
             ethercatSupervisor.join();
             systemSupervisor.join();
             monitor.join();
+            mailbox.join();
 
             ec_close();
             Kernel::stop_low_latency();
@@ -261,6 +275,9 @@ int main()
             .compensation = toff,
             .integral = integral,
             .state = ec_slave[0].state,
+            .recoveries = fsm.status.ethercat.recoveries,
+            .lastDropout = fsm.status.ethercat.lastDropout,
+            .update = updateStatistics.summary(),
         };
 
         // calculate toff to get linux time and DC synced